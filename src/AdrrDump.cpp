@@ -0,0 +1,68 @@
+#include "AdrrDump.h"
+
+#include <stdio.h>
+#include <new>
+
+AdrrDump::AdrrDump(uint16_t startAddr, uint16_t length, uint16_t readParam, bool hexOutput, unsigned long readInterval)
+    : _startAddr(startAddr), _length(length), _hexOutput(hexOutput), _readInterval(readInterval), readParam(readParam)
+{
+  // whole dump is kept until it is sent (+1 for the terminating 0 written by snprintf)
+  size_t outputSize = (hexOutput ? (length + 7) / 8 * ADRR_DUMP_HEX_LINE_LENGTH : length * 2) + 1;
+  _output = new (std::nothrow) char[outputSize];
+  if (!_output)
+    _failed = true;
+}
+
+AdrrDump::~AdrrDump()
+{
+  delete[] _output;
+}
+
+unsigned long AdrrDump::nextReadDelay(unsigned long nowMillis) const
+{
+  unsigned long elapsed = nowMillis - _lastReadMillis;
+  if (!_readStarted || elapsed >= _readInterval)
+    return 0;
+
+  return _readInterval - elapsed;
+}
+
+bool AdrrDump::step(unsigned long nowMillis, const ReadFunction &read)
+{
+  if (done())
+    return true;
+
+  // let the stove panel use the bus between two memory reads
+  if (nextReadDelay(nowMillis))
+    return false;
+
+  uint16_t address = _startAddr + _read;
+  uint16_t value = 0;
+
+  _readStarted = true;
+  _lastReadMillis = nowMillis;
+
+  if (!read(address, value))
+  {
+    _failed = true;
+    return true;
+  }
+
+  if (_hexOutput)
+  {
+    if (_read % 8 == 0)
+      _outputLength += snprintf(_output + _outputLength, 6, "%04x:", (unsigned int)address);
+    _outputLength += snprintf(_output + _outputLength, 6, " %04x", (unsigned int)value);
+    if (_read % 8 == 7 || _read == _length - 1)
+      _outputLength += snprintf(_output + _outputLength, 3, "\r\n");
+  }
+  else
+  {
+    _output[_outputLength++] = value & 0xFF;
+    _output[_outputLength++] = value >> 8;
+  }
+
+  _read++;
+
+  return done();
+}
@@ -0,0 +1,58 @@
+#ifndef AdrrDump_h
+#define AdrrDump_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+
+// Stove memory dump (BKP ADRR) read address by address, paced to not starve the stove panel
+// BIN : 2 bytes per address (little endian)
+// HEX : one line of 8 values per 8 addresses ("2000: 0012 00ff ...\r\n")
+// No Arduino dependency so it can be unit tested on host (pio test -e native)
+
+#define ADRR_DUMP_HEX_LINE_LENGTH 47 // "xxxx:" + 8 x " xxxx" + "\r\n"
+
+class AdrrDump
+{
+public:
+  // read one address, return false on stove communication failure
+  typedef std::function<bool(uint16_t address, uint16_t &value)> ReadFunction;
+
+private:
+  uint16_t _startAddr;
+  uint16_t _length;
+  bool _hexOutput;
+  unsigned long _readInterval;
+
+  uint16_t _read = 0; // addresses already read
+  bool _failed = false;
+  bool _readStarted = false;
+  unsigned long _lastReadMillis = 0;
+
+  char *_output = nullptr;
+  size_t _outputLength = 0;
+
+public:
+  uint16_t readParam; // same second parameter as EXT ADRD, passed through to the reader
+
+  AdrrDump(uint16_t startAddr, uint16_t length, uint16_t readParam, bool hexOutput, unsigned long readInterval);
+  ~AdrrDump();
+  AdrrDump(const AdrrDump &) = delete;
+  AdrrDump &operator=(const AdrrDump &) = delete;
+
+  // read next address if the read interval is elapsed, return true when dump is complete (or failed)
+  bool step(unsigned long nowMillis, const ReadFunction &read);
+  // time to wait (in ms) before next read can be done
+  unsigned long nextReadDelay(unsigned long nowMillis) const;
+
+  bool done() const { return _failed || _read == _length; };
+  bool failed() const { return _failed; };
+  bool hexOutput() const { return _hexOutput; };
+  uint16_t startAddr() const { return _startAddr; };
+  uint16_t addressesRead() const { return _read; };
+
+  const char *output() const { return _output; };
+  size_t outputLength() const { return _outputLength; };
+};
+
+#endif
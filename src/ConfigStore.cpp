@@ -0,0 +1,149 @@
+#include "ConfigStore.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <new>
+
+ConfigStore::ConfigStore(ConfigFS &fs, const char *basePath, uint16_t version, uint16_t recordSize)
+    : _fs(fs), _version(version), _recordSize(recordSize)
+{
+  snprintf(_jsonPath, sizeof(_jsonPath), "%s.json", basePath);
+  snprintf(_jsonTmpPath, sizeof(_jsonTmpPath), "%s.json.tmp", basePath);
+  snprintf(_recordPath, sizeof(_recordPath), "%s.bin", basePath);
+  snprintf(_recordTmpPath, sizeof(_recordTmpPath), "%s.bin.tmp", basePath);
+}
+
+uint32_t ConfigStore::crc32(const uint8_t *data, size_t length, uint32_t crc /* = 0 */)
+{
+  crc = ~crc;
+  while (length--)
+  {
+    crc ^= *data++;
+    for (uint8_t i = 0; i < 8; i++)
+      crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+  }
+  return ~crc;
+}
+
+// CRC of a whole file, return false if it doesn't exist
+bool ConfigStore::fileCrc(const char *path, uint32_t &crc)
+{
+  long size = _fs.fileSize(path);
+  if (size < 0)
+    return false;
+
+  uint8_t *buffer = new (std::nothrow) uint8_t[size ? size : 1];
+  if (!buffer)
+    return false;
+
+  bool result = _fs.readFile(path, buffer, size) == size;
+  if (result)
+    crc = crc32(buffer, size);
+  delete[] buffer;
+
+  return result;
+}
+
+// read binary file, return false if it is missing or invalid (written by another firmware, truncated or corrupted)
+bool ConfigStore::readRecord(const char *path, RecordHeader &header, uint8_t *record)
+{
+  if (_fs.fileSize(path) != (long)(sizeof(RecordHeader) + _recordSize))
+    return false;
+
+  uint8_t *buffer = new (std::nothrow) uint8_t[sizeof(RecordHeader) + _recordSize];
+  if (!buffer)
+    return false;
+
+  bool result = false;
+  if (_fs.readFile(path, buffer, sizeof(RecordHeader) + _recordSize) == (long)(sizeof(RecordHeader) + _recordSize))
+  {
+    memcpy(&header, buffer, sizeof(header));
+    result = header.magic == CONFIG_RECORD_MAGIC && header.version == _version && header.size == _recordSize && crc32(buffer + sizeof(RecordHeader), _recordSize) == header.crc;
+    if (result && record)
+      memcpy(record, buffer + sizeof(RecordHeader), _recordSize);
+  }
+  delete[] buffer;
+
+  return result;
+}
+
+// save order : JSON tmp, record tmp, record rename, JSON rename
+// complete what a power cut interrupted once both new files are written, otherwise drop the new files
+void ConfigStore::recover()
+{
+  uint32_t jsonTmpCrc = 0;
+  bool jsonTmp = fileCrc(_jsonTmpPath, jsonTmpCrc);
+
+  if (_version)
+  {
+    RecordHeader header;
+    if (readRecord(_recordTmpPath, header, nullptr) && jsonTmp && header.jsonCrc == jsonTmpCrc)
+      _fs.rename(_recordTmpPath, _recordPath);
+    else
+      _fs.remove(_recordTmpPath);
+
+    // record already renamed : JSON goes with it
+    if (jsonTmp && readRecord(_recordPath, header, nullptr) && header.jsonCrc == jsonTmpCrc)
+      _fs.rename(_jsonTmpPath, _jsonPath);
+    else if (jsonTmp)
+      _fs.remove(_jsonTmpPath);
+  }
+  // JSON only : temporary file can't be known complete, previous JSON is kept
+  else if (jsonTmp)
+    _fs.remove(_jsonTmpPath);
+}
+
+bool ConfigStore::save(const char *json, size_t jsonLength, const uint8_t *record)
+{
+  if (!_fs.writeFile(_jsonTmpPath, (const uint8_t *)json, jsonLength))
+  {
+    _fs.remove(_jsonTmpPath);
+    return false;
+  }
+
+  if (_version)
+  {
+    uint8_t *buffer = new (std::nothrow) uint8_t[sizeof(RecordHeader) + _recordSize];
+    if (!buffer)
+    {
+      _fs.remove(_jsonTmpPath);
+      return false;
+    }
+
+    RecordHeader header;
+    header.magic = CONFIG_RECORD_MAGIC;
+    header.version = _version;
+    header.size = _recordSize;
+    header.crc = crc32(record, _recordSize);
+    header.jsonCrc = crc32((const uint8_t *)json, jsonLength);
+    memcpy(buffer, &header, sizeof(header));
+    memcpy(buffer + sizeof(RecordHeader), record, _recordSize);
+
+    bool written = _fs.writeFile(_recordTmpPath, buffer, sizeof(RecordHeader) + _recordSize);
+    delete[] buffer;
+
+    if (!written || !_fs.rename(_recordTmpPath, _recordPath))
+    {
+      _fs.remove(_recordTmpPath);
+      _fs.remove(_jsonTmpPath);
+      return false;
+    }
+  }
+
+  return _fs.rename(_jsonTmpPath, _jsonPath);
+}
+
+ConfigStore::LoadSource ConfigStore::load(uint8_t *record)
+{
+  recover();
+
+  uint32_t jsonCrc = 0;
+  bool json = fileCrc(_jsonPath, jsonCrc);
+
+  // record is used if it was saved with the current JSON (or if JSON is missing)
+  RecordHeader header;
+  if (_version && readRecord(_recordPath, header, record) && (!json || header.jsonCrc == jsonCrc))
+    return LoadRecord;
+
+  return json ? LoadJson : LoadNone;
+}
@@ -0,0 +1,79 @@
+#ifndef ConfigStore_h
+#define ConfigStore_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Config files of an application : JSON (read by every firmware, editable) and binary record (loaded without JSON parsing)
+// Both are written to a temporary file then renamed, the record keeps the CRC of the JSON written with it :
+// - a power cut during save leaves the previous config or the new one, never a partial one
+// - a JSON changed without its record (older firmware after a rollback) is detected and used instead of the record
+// No Arduino dependency so it can be unit tested on host (pio test -e native)
+
+#define CONFIG_RECORD_MAGIC 0x32464357 // "WCF2"
+
+// file system used by ConfigStore (LittleFS on target)
+class ConfigFS
+{
+public:
+  virtual ~ConfigFS() {}
+  // size of file, -1 if it doesn't exist
+  virtual long fileSize(const char *path) = 0;
+  // read up to size bytes from start of file, return bytes read (-1 if file doesn't exist)
+  virtual long readFile(const char *path, uint8_t *buffer, size_t size) = 0;
+  // create (or truncate) file with data, return false if it is not completely written
+  virtual bool writeFile(const char *path, const uint8_t *data, size_t length) = 0;
+  // replace to by from
+  virtual bool rename(const char *from, const char *to) = 0;
+  virtual bool remove(const char *path) = 0;
+};
+
+class ConfigStore
+{
+public:
+  typedef enum
+  {
+    LoadNone,   // no usable config (defaults are kept)
+    LoadRecord, // record copied into the provided buffer
+    LoadJson    // JSON file has to be parsed (no record, record invalid, or JSON more recent)
+  } LoadSource;
+
+  // binary file header (record follows)
+  typedef struct
+  {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;
+    uint32_t crc;     // CRC of record
+    uint32_t jsonCrc; // CRC of the JSON file saved with this record
+  } RecordHeader;
+
+private:
+  ConfigFS &_fs;
+  uint16_t _version; // record format (0 : JSON file only)
+  uint16_t _recordSize;
+
+  char _jsonPath[32];
+  char _jsonTmpPath[36];
+  char _recordPath[32];
+  char _recordTmpPath[36];
+
+  bool fileCrc(const char *path, uint32_t &crc);
+  bool readRecord(const char *path, RecordHeader &header, uint8_t *record);
+  void recover();
+
+public:
+  // basePath without extension ("/WiFi" : /WiFi.json and /WiFi.bin)
+  ConfigStore(ConfigFS &fs, const char *basePath, uint16_t version, uint16_t recordSize);
+
+  static uint32_t crc32(const uint8_t *data, size_t length, uint32_t crc = 0);
+
+  // write JSON and record (ignored if version is 0), return false if config was not saved
+  bool save(const char *json, size_t jsonLength, const uint8_t *record);
+  // finish or rollback an interrupted save then tell which config to load (record buffer is recordSize bytes)
+  LoadSource load(uint8_t *record);
+
+  const char *jsonPath() const { return _jsonPath; };
+};
+
+#endif
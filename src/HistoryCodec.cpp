@@ -0,0 +1,219 @@
+#include "HistoryCodec.h"
+#include <string.h>
+
+// MSB first bit writer, stops writing (and reports overflow) at the end of the buffer
+struct BitWriter
+{
+  uint8_t *buffer;
+  size_t size;
+  size_t bitPos = 0;
+
+  BitWriter(uint8_t *buffer, size_t size) : buffer(buffer), size(size) { memset(buffer, 0, size); }
+  bool overflow() const { return bitPos > size * 8; }
+
+  void write(uint32_t value, uint8_t nbBits)
+  {
+    while (nbBits--)
+    {
+      if (bitPos < size * 8 && ((value >> nbBits) & 1))
+        buffer[bitPos / 8] |= 0x80 >> (bitPos % 8);
+      bitPos++;
+    }
+  }
+};
+
+struct BitReader
+{
+  const uint8_t *buffer;
+  size_t size;
+  size_t bitPos = 0;
+
+  BitReader(const uint8_t *buffer, size_t size) : buffer(buffer), size(size) {}
+
+  uint32_t read(uint8_t nbBits)
+  {
+    uint32_t value = 0;
+    while (nbBits--)
+    {
+      value <<= 1;
+      if (bitPos < size * 8)
+        value |= (buffer[bitPos / 8] >> (7 - bitPos % 8)) & 1;
+      bitPos++;
+    }
+    return value;
+  }
+};
+
+// delta of delta buckets : '0' / '10'+7bits / '110'+9bits / '1110'+12bits / '1111'+32bits
+static void encodeTime(BitWriter &writer, int32_t dod)
+{
+  if (dod == 0)
+    writer.write(0, 1);
+  else if (dod >= -63 && dod <= 64)
+  {
+    writer.write(0b10, 2);
+    writer.write(dod + 63, 7);
+  }
+  else if (dod >= -255 && dod <= 256)
+  {
+    writer.write(0b110, 3);
+    writer.write(dod + 255, 9);
+  }
+  else if (dod >= -2047 && dod <= 2048)
+  {
+    writer.write(0b1110, 4);
+    writer.write(dod + 2047, 12);
+  }
+  else
+  {
+    writer.write(0b1111, 4);
+    writer.write(dod, 32);
+  }
+}
+
+static int32_t decodeTime(BitReader &reader)
+{
+  if (!reader.read(1))
+    return 0;
+  if (!reader.read(1))
+    return (int32_t)reader.read(7) - 63;
+  if (!reader.read(1))
+    return (int32_t)reader.read(9) - 255;
+  if (!reader.read(1))
+    return (int32_t)reader.read(12) - 2047;
+  return (int32_t)reader.read(32);
+}
+
+// XOR with previous value : '0' same value / '10' + bits inside previous window / '11' + leading(4) + length-1(4) + bits
+typedef struct
+{
+  uint16_t previous;
+  uint8_t leading;
+  uint8_t length; // 0 : no window yet
+} XorState;
+
+static void encodeValue(BitWriter &writer, XorState &state, uint16_t value)
+{
+  uint16_t xorValue = value ^ state.previous;
+  state.previous = value;
+
+  if (!xorValue)
+  {
+    writer.write(0, 1);
+    return;
+  }
+
+  uint8_t leading = __builtin_clz(xorValue) - 16;
+  uint8_t trailing = __builtin_ctz(xorValue);
+
+  if (state.length && leading >= state.leading && trailing >= 16 - state.leading - state.length)
+  {
+    writer.write(0b10, 2);
+    writer.write(xorValue >> (16 - state.leading - state.length), state.length);
+    return;
+  }
+
+  state.leading = leading;
+  state.length = 16 - leading - trailing;
+  writer.write(0b11, 2);
+  writer.write(state.leading, 4);
+  writer.write(state.length - 1, 4);
+  writer.write(xorValue >> trailing, state.length);
+}
+
+static uint16_t decodeValue(BitReader &reader, XorState &state)
+{
+  if (reader.read(1))
+  {
+    if (reader.read(1))
+    {
+      state.leading = reader.read(4);
+      state.length = reader.read(4) + 1;
+
+      // corrupted window (can't be produced by encoder)
+      if (state.leading + state.length > 16)
+        state.length = 16 - state.leading;
+    }
+    state.previous ^= reader.read(state.length) << (16 - state.leading - state.length);
+  }
+  return state.previous;
+}
+
+bool historyBlockHeader(const uint8_t *block, size_t blockSize, HistoryBlockHeader &header)
+{
+  if (blockSize < sizeof(HistoryBlockHeader))
+    return false;
+
+  // block may not be aligned
+  memcpy(&header, block, sizeof(header));
+
+  return header.version == HISTORY_BLOCK_VERSION && header.samples && header.size >= sizeof(HistoryBlockHeader) && header.size <= blockSize;
+}
+
+uint16_t historyEncodeBlock(const HistorySample *samples, uint16_t nb, uint8_t *block, size_t blockSize)
+{
+  if (!nb || nb > UINT8_MAX || blockSize < sizeof(HistoryBlockHeader))
+    return 0;
+
+  BitWriter writer(block + sizeof(HistoryBlockHeader), blockSize - sizeof(HistoryBlockHeader));
+
+  // time column
+  writer.write(samples[0].time, 32);
+  int32_t previousDelta = 3600;
+  for (uint16_t i = 1; i < nb; i++)
+  {
+    int32_t delta = samples[i].time - samples[i - 1].time;
+    encodeTime(writer, delta - previousDelta);
+    previousDelta = delta;
+  }
+
+  // fields columns
+  for (uint8_t field = 0; field < HISTORY_FIELD_COUNT; field++)
+  {
+    XorState state = {(uint16_t)samples[0].values[field], 0, 0};
+    writer.write(state.previous, 16);
+    for (uint16_t i = 1; i < nb; i++)
+      encodeValue(writer, state, samples[i].values[field]);
+  }
+
+  if (writer.overflow())
+    return 0;
+
+  HistoryBlockHeader header;
+  header.sequence = 0;
+  header.samples = nb;
+  header.version = HISTORY_BLOCK_VERSION;
+  header.size = sizeof(HistoryBlockHeader) + (writer.bitPos + 7) / 8;
+  memcpy(block, &header, sizeof(header));
+
+  return header.size;
+}
+
+uint16_t historyDecodeBlock(const uint8_t *block, size_t blockSize, HistorySample *samples, uint16_t maxSamples)
+{
+  HistoryBlockHeader header;
+  if (!historyBlockHeader(block, blockSize, header) || header.samples > maxSamples)
+    return 0;
+
+  // reader can't go past used bytes (missing bits are read as 0)
+  BitReader reader(block + sizeof(HistoryBlockHeader), header.size - sizeof(HistoryBlockHeader));
+  uint16_t nb = header.samples;
+
+  samples[0].time = reader.read(32);
+  int32_t previousDelta = 3600;
+  for (uint16_t i = 1; i < nb; i++)
+  {
+    previousDelta += decodeTime(reader);
+    samples[i].time = samples[i - 1].time + previousDelta;
+  }
+
+  for (uint8_t field = 0; field < HISTORY_FIELD_COUNT; field++)
+  {
+    XorState state = {(uint16_t)reader.read(16), 0, 0};
+    samples[0].values[field] = state.previous;
+    for (uint16_t i = 1; i < nb; i++)
+      samples[i].values[field] = decodeValue(reader, state);
+  }
+
+  return nb;
+}
@@ -0,0 +1,37 @@
+#ifndef HistoryCodec_h
+#define HistoryCodec_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Compression of history samples by blocks, column by column
+// (Gorilla like : delta of delta for time, XOR with previous value for fields)
+// No Arduino dependency so it can be unit tested on host (pio test -e native)
+
+#define HISTORY_FIELD_COUNT 11
+#define HISTORY_BLOCK_VERSION 2
+
+typedef struct
+{
+  uint32_t time; // unix time (from stove clock)
+  int16_t values[HISTORY_FIELD_COUNT];
+} HistorySample;
+
+typedef struct
+{
+  uint32_t sequence; // block number, increased at each block written (0 : not set)
+  uint8_t samples;
+  uint8_t version;
+  uint16_t size; // used bytes (header included)
+} HistoryBlockHeader;
+
+// encode samples into block (header sequence is left to 0), return used bytes or 0 if they don't fit
+uint16_t historyEncodeBlock(const HistorySample *samples, uint16_t nb, uint8_t *block, size_t blockSize);
+
+// decode a block of blockSize bytes into samples, return the number of samples (0 if block is invalid)
+uint16_t historyDecodeBlock(const uint8_t *block, size_t blockSize, HistorySample *samples, uint16_t maxSamples);
+
+// read header of a block, return false if block is invalid
+bool historyBlockHeader(const uint8_t *block, size_t blockSize, HistoryBlockHeader &header);
+
+#endif
@@ -19,8 +19,43 @@
 
 // Control EventSourceMan code (To be used by Application if EventSource server is needed)
 #define EVTSRC_ENABLED 1
-#define EVTSRC_MAX_CLIENTS 2
-#define EVTSRC_KEEPALIVE_ENABLED 0
+#define EVTSRC_MAX_CLIENTS 4            // max clients per EventSource (also limited by free heap)
+#define EVTSRC_CLIENT_BUFFER_SIZE 1536  // pending bytes per client (events are dropped when full)
+#define EVTSRC_HEAP_RESERVE 12000       // free heap to keep when accepting a new client
+#define EVTSRC_BACKLOG_EVENTS 8         // last events replayed to reconnecting clients (Last-Event-ID)
+#define EVTSRC_MAX_DROPS 3              // consecutive dropped events before evicting a slow client
+#define EVTSRC_PING_INTERVAL 15000      // comment sent to idle clients to detect dead sockets (in ms)
+#define EVTSRC_STALL_TIMEOUT 10000      // client evicted if pending data are not sent for this time (in ms)
+
+// Control WebSocketMan code (bidirectional stream : status updates to clients, commands from clients)
+#define WS_ENABLED 1
+#define WS_PORT 81
+
+// Measure duration of main loop stages (exposed on /perf)
+#define PERF_ENABLED 1
+
+// Record trace events in RAM (downloadable on /trace as Chrome trace_event JSON)
+// (enabled by the *_trace environments of platformio.ini)
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 0
+#endif
+#define TRACE_BUFFER_EVENTS 256
+
+// Keep hour averages of stove history in LittleFS so they survive reboots (blocks of 12 hours compressed to ~130 bytes, 60 days kept)
+// (one small file written twice a day : flash wear is negligible, disable it to keep LittleFS untouched)
+#ifndef HISTORY_FS_ENABLED
+#define HISTORY_FS_ENABLED 1
+#endif
+
+// Track heap low-water marks and heap usage per subsystem (exposed in Core status and on diag/heap MQTT topic)
+#define HEAP_MONITOR_ENABLED 1
+
+// Shorten time to first publish after a power outage : known WiFi is joined without channel scan
+#define FAST_BOOT 1
+
+// Reuse last DHCP lease as static IP during WiFi fast reconnect
+// (faster but DHCP server is not contacted : only safe if the DHCP server reserves this address for the device)
+#define WIFI_FAST_CONNECT_CACHED_LEASE 0
 
 // Enable developper mode
 #define DEVELOPPER_MODE 0
@@ -34,12 +69,45 @@
 // Choose Log Serial Speed
 #define LOG_SERIAL_SPEED 38400
 
+// Log Level : messages with a higher level are removed at compile time
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
+#define LOG_LEVEL LOG_LEVEL_INFO
+
+// Log through a RAM ring buffer drained from loop() (0 to write synchronously to LOG_SERIAL)
+#define LOG_ASYNC_ENABLED 1
+#define LOG_BUFFER_SIZE 2048
+#define LOG_LINE_MAX_LENGTH 160
+
+// Send log lines to a syslog server
+// #define LOG_SYSLOG_SERVER "192.168.1.2"
+// #define LOG_SYSLOG_PORT 514
+
 // Log Serial Macros
 #ifdef LOG_SERIAL
-#define LOG_SERIAL_PRINT(...) LOG_SERIAL.print(__VA_ARGS__)
-#define LOG_SERIAL_PRINTLN(...) LOG_SERIAL.println(__VA_ARGS__)
-#define LOG_SERIAL_PRINTF(...) LOG_SERIAL.printf(__VA_ARGS__)
-#define LOG_SERIAL_PRINTF_P(...) LOG_SERIAL.printf_P(__VA_ARGS__)
+#if LOG_ASYNC_ENABLED
+#include "base/Logger.h"
+#define LOG_OUTPUT Log
+#else
+#define LOG_OUTPUT LOG_SERIAL
+#endif
+#endif
+
+#if defined(LOG_SERIAL) && LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR_PRINTLN(...) LOG_OUTPUT.println(__VA_ARGS__)
+#define LOG_ERROR_PRINTF_P(...) LOG_OUTPUT.printf_P(__VA_ARGS__)
+#else
+#define LOG_ERROR_PRINTLN(...)
+#define LOG_ERROR_PRINTF_P(...)
+#endif
+
+#if defined(LOG_SERIAL) && LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_SERIAL_PRINT(...) LOG_OUTPUT.print(__VA_ARGS__)
+#define LOG_SERIAL_PRINTLN(...) LOG_OUTPUT.println(__VA_ARGS__)
+#define LOG_SERIAL_PRINTF(...) LOG_OUTPUT.printf(__VA_ARGS__)
+#define LOG_SERIAL_PRINTF_P(...) LOG_OUTPUT.printf_P(__VA_ARGS__)
 #else
 #define LOG_SERIAL_PRINT(...)
 #define LOG_SERIAL_PRINTLN(...)
@@ -47,6 +115,14 @@
 #define LOG_SERIAL_PRINTF_P(...)
 #endif
 
+#if defined(LOG_SERIAL) && LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG_PRINTLN(...) LOG_OUTPUT.println(__VA_ARGS__)
+#define LOG_DEBUG_PRINTF_P(...) LOG_OUTPUT.printf_P(__VA_ARGS__)
+#else
+#define LOG_DEBUG_PRINTLN(...)
+#define LOG_DEBUG_PRINTF_P(...)
+#endif
+
 // Choose Pin used to boot in Rescue Mode
 // #define RESCUE_BTN_PIN 2
 
@@ -0,0 +1,172 @@
+#include "ReleaseInfo.h"
+
+#include <string.h>
+
+static const char *const keys[4] = {"\"tag_name\":", "\"name\":", "\"published_at\":", "\"body\":"};
+static const char summaryEnd[] = "\r\n\r\n##";
+
+ReleaseInfoParser::ReleaseInfoParser(ReleaseInfo &info) : _info(info)
+{
+  memset(&_info, 0, sizeof(_info));
+}
+
+// copy one unescaped char of the value being read
+void ReleaseInfoParser::valueChar(char c)
+{
+  if (_targetLength < _targetSize)
+  {
+    _target[_targetLength++] = c;
+    _target[_targetLength] = 0;
+  }
+
+  // for summary, stop at "\r\n\r\n##" (marker is removed)
+  if (_target == _info.summary)
+  {
+    _summaryEndMatch = (c == summaryEnd[_summaryEndMatch]) ? _summaryEndMatch + 1 : (c == '\r' ? 1 : 0);
+    if (!summaryEnd[_summaryEndMatch])
+    {
+      if (_targetLength >= 6 && !strcmp(_target + _targetLength - 6, summaryEnd))
+        _target[_targetLength - 6] = 0;
+      _state = SkipValue;
+    }
+  }
+}
+
+bool ReleaseInfoParser::feed(char c)
+{
+  if (complete())
+    return false;
+
+  switch (_state)
+  {
+  case SeekKey:
+  {
+    if (_inString)
+    {
+      if (_escaped)
+        _escaped = false;
+      else if (c == '\\')
+        _escaped = true;
+      else if (c == '"')
+        _inString = false;
+    }
+    else if (c == '"')
+      _inString = true;
+    // if c is a brace or bracket, increment or decrement the treeLevel
+    else if (c == '{' || c == '[')
+      _treeLevel++;
+    else if (c == '}' || c == ']')
+      _treeLevel--;
+
+    // if we are not at the first treeLevel, skip the character
+    if (_treeLevel > 1)
+      return true;
+
+    // advance each key matcher
+    int8_t keyFound = -1;
+    for (uint8_t k = 0; k < 4; k++)
+    {
+      if (c == keys[k][_keyMatch[k]])
+        _keyMatch[k]++;
+      else
+        _keyMatch[k] = (c == '"') ? 1 : 0; // all keys start with a quote
+
+      if (!keys[k][_keyMatch[k]])
+      {
+        _keyMatch[k] = 0;
+        if (!(_keysFound & (1 << k)))
+          keyFound = k;
+      }
+    }
+
+    if (keyFound < 0)
+      return true;
+
+    // key ends with ':' so the quote closing it was seen : value starts outside of a string
+    _inString = false;
+    _key = keyFound;
+    char *targets[4] = {_info.version, _info.title, _info.releaseDate, _info.summary};
+    const size_t targetSizes[4] = {sizeof(_info.version) - 1, sizeof(_info.title) - 1, sizeof(_info.releaseDate) - 1, sizeof(_info.summary) - 1};
+    _target = targets[keyFound];
+    _targetSize = targetSizes[keyFound];
+    _targetLength = 0;
+    _summaryEndMatch = 0;
+    _state = SeekValue;
+    break;
+  }
+
+  case SeekValue:
+    // read until the next quote (should be next to semicolon)
+    if (c == '"')
+    {
+      _escaped = false;
+      // for name/title key, skip text until the first space
+      _state = (_target == _info.title) ? SkipWord : ReadValue;
+    }
+    break;
+
+  case SkipWord:
+    if (c == ' ')
+      _state = ReadValue;
+    // single word name : title is empty
+    else if (c == '"')
+    {
+      _keysFound |= (1 << _key);
+      _state = SeekKey;
+    }
+    break;
+
+  case ReadValue:
+  case SkipValue:
+    if (!_escaped && c == '\\')
+    {
+      _escaped = true;
+      break;
+    }
+
+    // end of value
+    if (!_escaped && c == '"')
+    {
+      _keysFound |= (1 << _key);
+      _state = SeekKey;
+      break;
+    }
+
+    if (_escaped)
+    {
+      if (c == 'n')
+        c = '\n';
+      else if (c == 'r')
+        c = '\r';
+      _escaped = false;
+    }
+
+    if (_state == ReadValue)
+      valueChar(c);
+    break;
+  }
+
+  return !complete();
+}
+
+bool ReleaseInfoCache::notModified(unsigned long nowMillis)
+{
+  if (!_valid)
+    return false;
+
+  _fetchMillis = nowMillis;
+  return true;
+}
+
+bool ReleaseInfoCache::update(const ReleaseInfo &info, const char *etag, unsigned long nowMillis)
+{
+  if (!info.version[0])
+    return false;
+
+  _info = info;
+  strncpy(_etag, etag ? etag : "", sizeof(_etag) - 1);
+  _etag[sizeof(_etag) - 1] = 0;
+  _fetchMillis = nowMillis;
+  _valid = true;
+  return true;
+}
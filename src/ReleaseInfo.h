@@ -0,0 +1,77 @@
+#ifndef ReleaseInfo_h
+#define ReleaseInfo_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Latest firmware release info (GitHub releases/latest answer) :
+// streaming parser (one char at a time, nothing allocated) and cache revalidated using ETag
+// No Arduino dependency so it can be unit tested on host (pio test -e native)
+
+typedef struct
+{
+  char version[10];     // tag_name
+  char title[64];       // name, without its first word
+  char releaseDate[11]; // published_at, date part
+  char summary[256];    // body, up to the first "##" title
+} ReleaseInfo;
+
+class ReleaseInfoParser
+{
+private:
+  typedef enum
+  {
+    SeekKey,     // scanning top level object for wanted keys
+    SeekValue,   // key found, waiting for the opening quote of its value
+    SkipWord,    // name : first word is skipped
+    ReadValue,   // copying value
+    SkipValue    // summary end marker found, skipping remaining chars of the value
+  } State;
+
+  ReleaseInfo &_info;
+
+  State _state = SeekKey;
+  uint8_t _treeLevel = 0; // used to skip unwanted data (there is some "name" key in assets)
+  bool _inString = false; // braces inside strings must not change treeLevel
+  bool _escaped = false;
+  uint8_t _keyMatch[4] = {0, 0, 0, 0}; // number of chars of each key matched so far
+  uint8_t _keysFound = 0;              // bitmask of keys already read
+  uint8_t _key = 0;                    // key of the value being read
+  char *_target = nullptr;
+  size_t _targetSize = 0; // max length of value
+  size_t _targetLength = 0;
+  uint8_t _summaryEndMatch = 0;
+
+  void valueChar(char c);
+
+public:
+  explicit ReleaseInfoParser(ReleaseInfo &info);
+
+  // parse next char of the answer, return false once all keys are read (rest of the answer can be skipped)
+  bool feed(char c);
+  bool complete() const { return _keysFound == 0x0F; };
+};
+
+class ReleaseInfoCache
+{
+private:
+  ReleaseInfo _info = {};
+  char _etag[72] = {0};
+  unsigned long _fetchMillis = 0;
+  bool _valid = false;
+
+public:
+  const ReleaseInfo &info() const { return _info; };
+  bool valid() const { return _valid; };
+
+  // cached info can be served without any request (revalidate : user asked for an up to date answer)
+  bool fresh(unsigned long nowMillis, unsigned long ttl, bool revalidate = false) const { return !revalidate && _valid && nowMillis - _fetchMillis < ttl; };
+  // value of If-None-Match header (nullptr if there is nothing to revalidate)
+  const char *ifNoneMatch() const { return _valid && _etag[0] ? _etag : nullptr; };
+  // 304 answer : cached info is still the latest one, return false if there is no cached info
+  bool notModified(unsigned long nowMillis);
+  // 200 answer parsed into info, return false (and keep previous info) if it has no version
+  bool update(const ReleaseInfo &info, const char *etag, unsigned long nowMillis);
+};
+
+#endif
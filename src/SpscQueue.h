@@ -0,0 +1,47 @@
+#ifndef SpscQueue_h
+#define SpscQueue_h
+
+#include <atomic>
+
+// Lock-free single producer / single consumer queue
+// (one task pushes, another one pops, capacity is N-1 items)
+template <typename T, size_t N>
+class SpscQueue
+{
+private:
+  T _items[N];
+  std::atomic<size_t> _head{0}; // next slot to write (producer side)
+  std::atomic<size_t> _tail{0}; // next slot to read (consumer side)
+
+public:
+  bool push(const T &item)
+  {
+    size_t head = _head.load(std::memory_order_relaxed);
+    size_t next = (head + 1) % N;
+
+    // queue is full
+    if (next == _tail.load(std::memory_order_acquire))
+      return false;
+
+    _items[head] = item;
+    _head.store(next, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T &item)
+  {
+    size_t tail = _tail.load(std::memory_order_relaxed);
+
+    // queue is empty
+    if (tail == _head.load(std::memory_order_acquire))
+      return false;
+
+    item = _items[tail];
+    _tail.store((tail + 1) % N, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() { return _tail.load(std::memory_order_acquire) == _head.load(std::memory_order_acquire); };
+};
+
+#endif
@@ -0,0 +1,40 @@
+#include "StoveBusAdmission.h"
+
+StoveBusAdmission::StoveBusAdmission(uint8_t capacity, uint8_t backgroundSlots)
+    : _capacity(capacity), _backgroundSlots(backgroundSlots < capacity ? backgroundSlots : capacity)
+{
+}
+
+uint8_t StoveBusAdmission::available(bool background) const
+{
+  uint8_t free = _capacity - _inFlight;
+
+  // background jobs are only limited by their own count : user jobs in flight don't shrink their share
+  if (background && _backgroundSlots - _backgroundInFlight < free)
+    free = _backgroundSlots - _backgroundInFlight;
+
+  return free;
+}
+
+bool StoveBusAdmission::admit(bool background)
+{
+  if (!available(background))
+  {
+    _refused++;
+    return false;
+  }
+
+  _inFlight++;
+  if (background)
+    _backgroundInFlight++;
+
+  return true;
+}
+
+void StoveBusAdmission::release(bool background)
+{
+  if (_inFlight)
+    _inFlight--;
+  if (background && _backgroundInFlight)
+    _backgroundInFlight--;
+}
@@ -0,0 +1,38 @@
+#ifndef StoveBusAdmission_h
+#define StoveBusAdmission_h
+
+#include <stdint.h>
+
+// Admission of jobs to the stove bus (used by loop() only : jobs are admitted when queued and released when their result is processed)
+// Each job in flight has a slot reserved in the results queue,
+// background polling is limited to its own share of them so user commands always find room
+// No Arduino dependency so it can be unit tested on host (pio test -e native)
+
+class StoveBusAdmission
+{
+private:
+  uint8_t _capacity;        // slots shared by all jobs
+  uint8_t _backgroundSlots; // max background jobs among them
+
+  uint8_t _inFlight = 0;
+  uint8_t _backgroundInFlight = 0;
+  uint32_t _refused = 0;
+
+public:
+  StoveBusAdmission(uint8_t capacity, uint8_t backgroundSlots);
+
+  // number of jobs which can be admitted right now (publish cycle checks its commands fit before queuing any of them)
+  uint8_t available(bool background) const;
+  // reserve a slot, return false (and count it as refused) if there is none left
+  bool admit(bool background);
+  // free the slot of a processed job
+  void release(bool background);
+  // count jobs refused without calling admit (whole publish cycle)
+  void refuse(uint8_t count) { _refused += count; };
+
+  uint8_t inFlight() const { return _inFlight; };
+  uint8_t backgroundInFlight() const { return _backgroundInFlight; };
+  uint32_t refused() const { return _refused; };
+};
+
+#endif
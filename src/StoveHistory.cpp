@@ -0,0 +1,478 @@
+#include "StoveHistory.h"
+
+static_assert(StoveHistory::FieldCount == HISTORY_FIELD_COUNT, "HISTORY_FIELD_COUNT must match StoveHistory fields");
+
+// JSON keys of recorded fields (same order as Field enum)
+static const char fieldKey0[] PROGMEM = "T1";
+static const char fieldKey1[] PROGMEM = "T2";
+static const char fieldKey2[] PROGMEM = "T3";
+static const char fieldKey3[] PROGMEM = "T4";
+static const char fieldKey4[] PROGMEM = "T5";
+static const char fieldKey5[] PROGMEM = "SETP";
+static const char fieldKey6[] PROGMEM = "PWR";
+static const char fieldKey7[] PROGMEM = "STATUS";
+static const char fieldKey8[] PROGMEM = "F2L";
+static const char fieldKey9[] PROGMEM = "DP_PRESS";
+static const char fieldKey10[] PROGMEM = "PQT";
+static const char *const fieldKeys[StoveHistory::FieldCount] PROGMEM = {fieldKey0, fieldKey1, fieldKey2, fieldKey3, fieldKey4, fieldKey5, fieldKey6, fieldKey7, fieldKey8, fieldKey9, fieldKey10};
+
+// temperatures and setpoint are stored in tenth of degree
+static bool isScaledField(uint8_t field)
+{
+  return field <= StoveHistory::SETP;
+}
+
+// state fields keep the last value of a period instead of the average
+static bool isStateField(uint8_t field)
+{
+  return field == StoveHistory::STATUS || field == StoveHistory::PQT;
+}
+
+// days since 1970-01-01 of a civil date (Howard Hinnant algorithm)
+static int32_t daysFromCivil(int y, unsigned m, unsigned d)
+{
+  y -= m <= 2;
+  const int era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = (unsigned)(y - era * 400);
+  const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int32_t)doe - 719468;
+}
+
+//------------------------------------------
+// Ring buffer helpers
+void StoveHistory::push(Ring &ring, const Sample &sample)
+{
+  ring.samples[ring.head] = sample;
+  ring.head = (ring.head + 1) % ring.size;
+  if (ring.count < ring.size)
+    ring.count++;
+}
+
+// index 0 is the oldest sample
+const StoveHistory::Sample &StoveHistory::at(const Ring &ring, uint16_t index)
+{
+  return ring.samples[(ring.head + ring.size - ring.count + index) % ring.size];
+}
+
+//------------------------------------------
+// Aggregation helpers
+void StoveHistory::resetAggregator(Aggregator &aggregator, uint32_t periodStart)
+{
+  aggregator.periodStart = periodStart;
+  for (uint8_t i = 0; i < FieldCount; i++)
+  {
+    aggregator.sums[i] = 0;
+    aggregator.counts[i] = 0;
+    aggregator.last[i] = NoValue;
+  }
+}
+
+// add sample to the aggregator, return true (and fill result) when a period is completed
+bool StoveHistory::aggregate(Aggregator &aggregator, const Sample &sample, uint32_t period, Sample &result)
+{
+  bool completed = false;
+  uint32_t periodStart = sample.time - sample.time % period;
+
+  if (aggregator.periodStart != periodStart)
+  {
+    // close the current period if it contains something
+    for (uint8_t i = 0; i < FieldCount && !completed; i++)
+      completed = aggregator.counts[i] > 0;
+
+    if (completed)
+    {
+      result.time = aggregator.periodStart;
+      for (uint8_t i = 0; i < FieldCount; i++)
+      {
+        if (!aggregator.counts[i])
+          result.values[i] = NoValue;
+        else if (isStateField(i))
+          result.values[i] = aggregator.last[i];
+        else
+          result.values[i] = aggregator.sums[i] / aggregator.counts[i];
+      }
+    }
+
+    resetAggregator(aggregator, periodStart);
+  }
+
+  for (uint8_t i = 0; i < FieldCount; i++)
+  {
+    if (sample.values[i] == NoValue)
+      continue;
+    aggregator.sums[i] += sample.values[i];
+    aggregator.counts[i]++;
+    aggregator.last[i] = sample.values[i];
+  }
+
+  return completed;
+}
+
+#if HISTORY_FS_ENABLED
+//------------------------------------------
+// LittleFS tier : one small file per block (a block is never modified once written, oldest file is overwritten),
+// each block holds up to HISTORY_FS_BLOCK_SAMPLES hour samples compressed by HistoryCodec
+static void blockFileName(char *fileName, size_t size, uint32_t sequence)
+{
+  snprintf_P(fileName, size, PSTR("/hist%03u.bin"), (unsigned int)(sequence % HISTORY_FS_BLOCKS));
+}
+
+// encode nb oldest pending hour samples into block, return false if it doesn't fit
+bool StoveHistory::encodeBlock(uint16_t nb, uint8_t *block)
+{
+  Sample samples[HISTORY_FS_BLOCK_SAMPLES];
+  uint16_t first = _hour.count - _fsPending;
+  for (uint16_t i = 0; i < nb; i++)
+    samples[i] = at(_hour, first + i);
+
+  return historyEncodeBlock(samples, nb, block, HISTORY_FS_BLOCK_SIZE) != 0;
+}
+
+// find the last block written (files of previous format are removed)
+void StoveHistory::scanFS()
+{
+  LittleFS.remove(String(F("/history.bin")));
+
+  uint8_t block[sizeof(HistoryBlockHeader)];
+  char fileName[16];
+  uint32_t lastSequence = 0;
+
+  for (uint16_t i = 0; i < HISTORY_FS_BLOCKS; i++)
+  {
+    blockFileName(fileName, sizeof(fileName), i);
+    File blockFile = LittleFS.open(fileName, "r");
+    if (!blockFile)
+      continue;
+
+    HistoryBlockHeader header;
+    size_t blockSize = blockFile.size();
+    if (blockFile.read(block, sizeof(block)) == sizeof(block) && historyBlockHeader(block, blockSize, header) && header.sequence % HISTORY_FS_BLOCKS == i && header.sequence > lastSequence)
+      lastSequence = header.sequence;
+    blockFile.close();
+  }
+
+  _fsNextSequence = lastSequence + 1;
+}
+
+// write pending hour samples as a new block file
+void StoveHistory::writeBlockFS()
+{
+  unsigned long startMicros = micros();
+
+  // put as many samples as possible in the block
+  uint8_t block[HISTORY_FS_BLOCK_SIZE];
+  uint16_t nb = min<uint16_t>(_fsPending, HISTORY_FS_BLOCK_SAMPLES);
+  while (nb > 1 && !encodeBlock(nb, block))
+    nb--;
+  if (nb == 1 && !encodeBlock(nb, block))
+    return;
+
+  uint32_t encodeMicros = micros() - startMicros;
+
+  HistoryBlockHeader header;
+  historyBlockHeader(block, HISTORY_FS_BLOCK_SIZE, header);
+  header.sequence = _fsNextSequence;
+  memcpy(block, &header, sizeof(header));
+
+  // only used bytes are written, oldest block file is replaced
+  char fileName[16];
+  blockFileName(fileName, sizeof(fileName), header.sequence);
+  File blockFile = LittleFS.open(fileName, "w");
+  if (!blockFile)
+    return;
+  size_t written = blockFile.write(block, header.size);
+  blockFile.close();
+  if (written != header.size)
+    return;
+
+  _fsNextSequence++;
+  _fsPending -= nb;
+  _fsEncodeMicros = encodeMicros;
+  _fsEncodedSamples += nb;
+  _fsEncodedBytes += header.size;
+}
+#endif
+
+//------------------------------------------
+StoveHistory::StoveHistory()
+{
+  for (uint8_t i = 0; i < FieldCount; i++)
+    _current[i] = NoValue;
+  resetAggregator(_minuteAggregator, 0);
+  resetAggregator(_hourAggregator, 0);
+}
+
+void StoveHistory::begin()
+{
+#if HISTORY_FS_ENABLED
+  scanFS();
+#endif
+}
+
+//------------------------------------------
+// Record the latest values of a stove answer (DATA object of any GET command)
+void StoveHistory::update(JsonObjectConst data)
+{
+  // stove clock gives the timeline (no NTP on this device)
+  const char *stoveDateTime = data["STOVE_DATETIME"];
+  if (stoveDateTime)
+  {
+    int year, month, day, hour, minute, second;
+    if (sscanf(stoveDateTime, "%d-%d-%d %d:%d:%d", &year, &month, &day, &hour, &minute, &second) == 6)
+    {
+      uint32_t stoveTime = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+      _timeOffset = stoveTime - millis() / 1000;
+      _timeKnown = true;
+    }
+  }
+
+  char fieldKey[10];
+  for (uint8_t i = 0; i < FieldCount; i++)
+  {
+    strcpy_P(fieldKey, (const char *)pgm_read_ptr(fieldKeys + i));
+    JsonVariantConst value = data[fieldKey];
+    if (value.isNull())
+      continue;
+
+    // some values are stored as raw JSON (serialized()) and can't be read using as<float>()
+    char strValue[16];
+    serializeJson(value, strValue, sizeof(strValue));
+    float fValue = atof(strValue);
+
+    _current[i] = (int16_t)(isScaledField(i) ? lroundf(fValue * 10) : lroundf(fValue));
+    _currentUpdated = true;
+  }
+}
+
+//------------------------------------------
+// Store values received since last call as a new sample (called once per publish cycle)
+void StoveHistory::commit()
+{
+  if (!_currentUpdated || !_timeKnown)
+    return;
+  _currentUpdated = false;
+
+  Sample sample;
+  sample.time = millis() / 1000 + _timeOffset;
+  memcpy(sample.values, _current, sizeof(_current));
+
+  push(_raw, sample);
+
+  Sample minuteSample;
+  if (!aggregate(_minuteAggregator, sample, 60, minuteSample))
+    return;
+  push(_minute, minuteSample);
+
+  Sample hourSample;
+  if (!aggregate(_hourAggregator, minuteSample, 3600, hourSample))
+    return;
+  push(_hour, hourSample);
+
+#if HISTORY_FS_ENABLED
+  // pending samples must stay in RAM tier until written (retried next hour if write failed)
+  if (_fsPending < HISTORY_HOUR_SAMPLES)
+    _fsPending++;
+  if (_fsPending >= HISTORY_FS_BLOCK_SAMPLES)
+    writeBlockFS();
+#endif
+}
+
+//------------------------------------------
+// Parse comma separated list of fields names into a mask (all fields if empty)
+uint16_t StoveHistory::parseFields(const String &fields)
+{
+  if (!fields.length())
+    return (1 << FieldCount) - 1;
+
+  uint16_t fieldMask = 0;
+  int start = 0;
+  while (start <= (int)fields.length())
+  {
+    int end = fields.indexOf(',', start);
+    if (end < 0)
+      end = fields.length();
+
+    String field = fields.substring(start, end);
+    for (uint8_t i = 0; i < FieldCount; i++)
+      if (field.equalsIgnoreCase(FPSTR((const char *)pgm_read_ptr(fieldKeys + i))))
+        fieldMask |= 1 << i;
+
+    start = end + 1;
+  }
+
+  return fieldMask;
+}
+
+//------------------------------------------
+// Add a sample to the stream buffer (flushed when nearly full)
+void StoveHistory::streamSample(StreamContext &context, const Sample &sample)
+{
+  if (sample.time < context.from || sample.time >= context.until)
+    return;
+
+  char *buffer = context.buffer;
+  size_t &pos = context.pos;
+  size_t size = sizeof(context.buffer);
+
+  // flush buffer if a full sample may not fit
+  if (pos > size - 128)
+  {
+    context.server.sendContent(buffer, pos);
+    pos = 0;
+  }
+
+  if (context.binary)
+  {
+    memcpy(buffer + pos, &sample.time, sizeof(sample.time));
+    pos += sizeof(sample.time);
+    for (uint8_t i = 0; i < FieldCount; i++)
+      if (context.fieldMask & (1 << i))
+      {
+        memcpy(buffer + pos, &sample.values[i], sizeof(sample.values[i]));
+        pos += sizeof(sample.values[i]);
+      }
+  }
+  else
+  {
+    pos += snprintf_P(buffer + pos, size - pos, PSTR("%s[%lu"), context.firstSample ? "" : ",", (unsigned long)sample.time);
+    for (uint8_t i = 0; i < FieldCount; i++)
+    {
+      if (!(context.fieldMask & (1 << i)))
+        continue;
+      if (sample.values[i] == NoValue)
+        pos += strlcpy_P(buffer + pos, PSTR(",null"), size - pos);
+      else if (isScaledField(i))
+        pos += snprintf_P(buffer + pos, size - pos, PSTR(",%s%d.%d"), sample.values[i] < 0 ? "-" : "", abs(sample.values[i]) / 10, abs(sample.values[i]) % 10);
+      else
+        pos += snprintf_P(buffer + pos, size - pos, PSTR(",%d"), sample.values[i]);
+    }
+    buffer[pos++] = ']';
+  }
+  context.firstSample = false;
+}
+
+#if HISTORY_FS_ENABLED
+// Decode stored blocks one by one (oldest first)
+void StoveHistory::streamFS(StreamContext &context)
+{
+  uint8_t *block = new uint8_t[HISTORY_FS_BLOCK_SIZE];
+  Sample *samples = new Sample[HISTORY_FS_BLOCK_SAMPLES];
+  char fileName[16];
+
+  uint32_t sequence = (_fsNextSequence > HISTORY_FS_BLOCKS) ? _fsNextSequence - HISTORY_FS_BLOCKS : 1;
+  for (; sequence < _fsNextSequence; sequence++)
+  {
+    blockFileName(fileName, sizeof(fileName), sequence);
+    File blockFile = LittleFS.open(fileName, "r");
+    if (!blockFile)
+      continue;
+    size_t blockSize = blockFile.read(block, HISTORY_FS_BLOCK_SIZE);
+    blockFile.close();
+
+    // file may belong to an older sequence if a write failed
+    HistoryBlockHeader header;
+    if (!historyBlockHeader(block, blockSize, header) || header.sequence != sequence)
+      continue;
+
+    uint16_t nb = historyDecodeBlock(block, blockSize, samples, HISTORY_FS_BLOCK_SAMPLES);
+
+    // skip blocks fully older than requested
+    if (!nb || samples[nb - 1].time < context.from)
+      continue;
+
+    for (uint16_t j = 0; j < nb; j++)
+      streamSample(context, samples[j]);
+  }
+
+  delete[] samples;
+  delete[] block;
+}
+#endif
+
+//------------------------------------------
+// Stream samples more recent than from (oldest first, coarser tiers only cover time not covered by finer ones)
+// JSON : {"fields":["T1",...],"samples":[[time,T1,...],...]}
+// binary : "PHST", version(1), fieldMask(2), then records of time(4) + selected fields(2 each, x10 for temperatures), little endian
+void StoveHistory::streamHistory(WebServer &server, uint32_t from, uint16_t fieldMask, bool binary)
+{
+  const Ring *tiers[] = {&_hour, &_minute, &_raw};
+  const uint8_t nbTiers = sizeof(tiers) / sizeof(tiers[0]);
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, binary ? F("application/octet-stream") : F("text/json"), "");
+
+  StreamContext context = {server, {0}, 0, from, UINT32_MAX, fieldMask, binary, true};
+  char *buffer = context.buffer;
+  size_t &pos = context.pos;
+
+  if (binary)
+  {
+    memcpy_P(buffer, PSTR("PHST\x01"), 5);
+    buffer[5] = fieldMask & 0xFF;
+    buffer[6] = fieldMask >> 8;
+    pos = 7;
+  }
+  else
+  {
+    pos = strlcpy_P(buffer, PSTR("{\"fields\":["), sizeof(context.buffer));
+    bool first = true;
+    for (uint8_t i = 0; i < FieldCount; i++)
+    {
+      if (!(fieldMask & (1 << i)))
+        continue;
+      if (!first)
+        buffer[pos++] = ',';
+      buffer[pos++] = '"';
+      pos += strlcpy_P(buffer + pos, (const char *)pgm_read_ptr(fieldKeys + i), sizeof(context.buffer) - pos);
+      buffer[pos++] = '"';
+      first = false;
+    }
+    pos += strlcpy_P(buffer + pos, PSTR("],\"samples\":["), sizeof(context.buffer) - pos);
+  }
+
+  for (uint8_t tier = 0; tier < nbTiers; tier++)
+  {
+    const Ring &ring = *tiers[tier];
+
+    // next finer tier with samples gives the upper bound of this one
+    context.until = UINT32_MAX;
+    for (uint8_t finer = tier + 1; finer < nbTiers && context.until == UINT32_MAX; finer++)
+      if (tiers[finer]->count)
+        context.until = at(*tiers[finer], 0).time;
+
+    uint16_t index = 0;
+#if HISTORY_FS_ENABLED
+    // hour tier comes from flash, only hours not written yet are taken from RAM
+    if (&ring == &_hour)
+    {
+      streamFS(context);
+      index = ring.count - _fsPending;
+    }
+#endif
+
+    for (; index < ring.count; index++)
+      streamSample(context, at(ring, index));
+  }
+
+  if (!binary)
+    pos += strlcpy_P(buffer + pos, PSTR("]}"), sizeof(context.buffer) - pos);
+
+  if (pos)
+    server.sendContent(buffer, pos);
+  server.sendContent(emptyString);
+}
+
+//------------------------------------------
+void StoveHistory::fillStatusJSON(JsonDocument &doc)
+{
+  doc[F("historysamples")] = _raw.count + _minute.count + _hour.count;
+#if HISTORY_FS_ENABLED
+  // compression efficiency of flash tier
+  if (_fsEncodedSamples)
+  {
+    doc[F("historybytespersample")] = (float)_fsEncodedBytes / _fsEncodedSamples;
+    doc[F("historyencodeus")] = _fsEncodeMicros;
+  }
+#endif
+}
@@ -0,0 +1,123 @@
+#ifndef StoveHistory_h
+#define StoveHistory_h
+
+#include "Main.h"
+#include "HistoryCodec.h"
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+
+#ifdef ESP8266
+#include <ESP8266WebServer.h>
+using WebServer = ESP8266WebServer;
+#else
+#include <WebServer.h>
+#endif
+
+// RAM tiers sizes (number of samples, a sample uses 28 bytes)
+#define HISTORY_RAW_SAMPLES 30    // samples at poll resolution
+#define HISTORY_MINUTE_SAMPLES 60 // 1 minute averages
+#define HISTORY_HOUR_SAMPLES 48   // 1 hour averages
+
+// LittleFS tier (HISTORY_FS_ENABLED in Main.h)
+#define HISTORY_FS_BLOCK_SIZE 256   // max size of a compressed block (one file per block)
+#define HISTORY_FS_BLOCK_SAMPLES 12 // hour samples per block (a block is written twice a day)
+#define HISTORY_FS_BLOCKS 120       // 60 days (120 files)
+
+class StoveHistory
+{
+public:
+  typedef enum
+  {
+    T1 = 0,
+    T2,
+    T3,
+    T4,
+    T5,
+    SETP,
+    PWR,
+    STATUS,
+    F2L,
+    DP,
+    PQT,
+    FieldCount
+  } Field;
+
+private:
+  static const int16_t NoValue = INT16_MIN;
+
+  typedef HistorySample Sample;
+
+  typedef struct
+  {
+    Sample *samples;
+    uint16_t size;
+    uint16_t head; // next slot to write
+    uint16_t count;
+  } Ring;
+
+  typedef struct
+  {
+    uint32_t periodStart;
+    int32_t sums[FieldCount];
+    uint16_t counts[FieldCount];
+    int16_t last[FieldCount];
+  } Aggregator;
+
+  Sample _rawSamples[HISTORY_RAW_SAMPLES];
+  Sample _minuteSamples[HISTORY_MINUTE_SAMPLES];
+  Sample _hourSamples[HISTORY_HOUR_SAMPLES];
+  Ring _raw = {_rawSamples, HISTORY_RAW_SAMPLES, 0, 0};
+  Ring _minute = {_minuteSamples, HISTORY_MINUTE_SAMPLES, 0, 0};
+  Ring _hour = {_hourSamples, HISTORY_HOUR_SAMPLES, 0, 0};
+  Aggregator _minuteAggregator;
+  Aggregator _hourAggregator;
+
+  int16_t _current[FieldCount];
+  bool _currentUpdated = false;
+  int32_t _timeOffset = 0; // stove unix time - uptime in seconds
+  bool _timeKnown = false;
+
+  static void push(Ring &ring, const Sample &sample);
+  static const Sample &at(const Ring &ring, uint16_t index);
+  static void resetAggregator(Aggregator &aggregator, uint32_t periodStart);
+  static bool aggregate(Aggregator &aggregator, const Sample &sample, uint32_t period, Sample &result);
+
+  typedef struct
+  {
+    WebServer &server;
+    char buffer[512];
+    size_t pos;
+    uint32_t from;
+    uint32_t until;
+    uint16_t fieldMask;
+    bool binary;
+    bool firstSample;
+  } StreamContext;
+
+  void streamSample(StreamContext &context, const Sample &sample);
+
+#if HISTORY_FS_ENABLED
+  uint16_t _fsPending = 0;       // hour samples not written to flash yet (last ones of _hour)
+  uint32_t _fsNextSequence = 1; // sequence of the next block to write
+  uint32_t _fsEncodedSamples = 0;
+  uint32_t _fsEncodedBytes = 0;
+  uint32_t _fsEncodeMicros = 0;
+
+  bool encodeBlock(uint16_t nb, uint8_t *block);
+  void scanFS();
+  void writeBlockFS();
+  void streamFS(StreamContext &context);
+#endif
+
+public:
+  StoveHistory();
+
+  void begin();
+  void update(JsonObjectConst data);
+  void commit();
+  static uint16_t parseFields(const String &fields);
+  void streamHistory(WebServer &server, uint32_t from, uint16_t fieldMask, bool binary);
+  void fillStatusJSON(JsonDocument &doc);
+};
+
+#endif
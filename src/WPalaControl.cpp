@@ -1,14 +1,31 @@
 #include "WPalaControl.h"
 
 #ifdef ESP8266
+#include <coredecls.h> // esp_delay
 #define PALA_SERIAL Serial
+#define HW_DETECT_PIN 5
 #else
 #define PALA_SERIAL Serial2
+#define HW_DETECT_PIN 22
 #endif
 
+// Answer of a command which didn't reach the stove (or failed before giving any data)
+static String palaCmdError(const String &cmd, const String &msg, bool timeout = false)
+{
+  String ret(F("{\"INFO\":{\"CMD\":\""));
+  ret += cmd;
+  ret += F("\",\"MSG\":\"");
+  ret += msg;
+  ret += (timeout ? F("\",\"RSP\":\"TIMEOUT\"},") : F("\",\"RSP\":\"ERROR\"},"));
+  ret += F("\"SUCCESS\":false,\"DATA\":{\"NODATA\":true}}");
+  return ret;
+}
+
 // Serial management functions -------------
 int WPalaControl::myOpenSerial(uint32_t baudrate)
 {
+  // RX buffer big enough to hold complete frames even if reader is late
+  PALA_SERIAL.setRxBufferSize(STOVE_RX_BUFFER_SIZE);
 #ifdef ESP8266
   LOG_SERIAL.flush();
   PALA_SERIAL.begin(baudrate);
@@ -16,9 +33,40 @@ int WPalaControl::myOpenSerial(uint32_t baudrate)
   pinMode(1, INPUT);
 #else
   PALA_SERIAL.begin(baudrate, SERIAL_8N1, 23, 5); // set ESP32 pins to match hat position (IO23(RX)/IO5(TX))
+
+  // UART RX timeout interrupt marks the end of a frame :
+  // UART driver event task wakes up mySelectSerial only once the complete frame is in RX buffer
+  PALA_SERIAL.setRxTimeout(STOVE_RX_TIMEOUT_SYMBOLS);
+  PALA_SERIAL.onReceive([this]()
+                        {
+                          stoveRxFrameReceived();
+                          xSemaphoreGive(_stoveRxSemaphore); },
+                        true);
+  PALA_SERIAL.onReceiveError([this](hardwareSerial_error_t error)
+                             {
+                               if (error == UART_BUFFER_FULL_ERROR || error == UART_FIFO_OVF_ERROR)
+                                 _stoveRxStats.overruns++;
+                               else
+                                 _stoveRxStats.errors++; });
 #endif
   return 0;
 }
+void WPalaControl::stoveRxFrameReceived()
+{
+  // only the first frame after a request is an answer
+  if (!_stoveRxFrameExpected)
+    return;
+  _stoveRxFrameExpected = false;
+
+  uint32_t latency = micros() - _stoveTxEndMicros;
+
+  if (!_stoveRxStats.frames || latency < _stoveRxStats.latencyMin)
+    _stoveRxStats.latencyMin = latency;
+  if (latency > _stoveRxStats.latencyMax)
+    _stoveRxStats.latencyMax = latency;
+  _stoveRxStats.latencyTotal += latency;
+  _stoveRxStats.frames++;
+}
 void WPalaControl::myCloseSerial()
 {
   PALA_SERIAL.end();
@@ -33,18 +81,86 @@ void WPalaControl::myCloseSerial()
 }
 int WPalaControl::mySelectSerial(unsigned long timeout)
 {
+  // stove is offline, don't wait for an answer that won't come
+  if (isStoveBusBlocked())
+    return 0;
+
+  TRACE_SCOPE("stoveWait");
+
+  // first wait after a request : use adaptive timeout of the current command class
+  bool firstWait = _stoveAwaitingAnswer;
+  bool shortened = false;
+  _stoveAwaitingAnswer = false;
+#if STOVE_RTO_ENABLED
+  if (firstWait && _stoveAdaptiveTimeout)
+  {
+    unsigned long rto = stoveRto(_stoveCmdClass);
+    if (rto && rto < timeout)
+    {
+      timeout = rto;
+      shortened = true;
+    }
+  }
+#endif
+
   size_t avail;
+  unsigned long startMicros = micros();
+#ifdef ESP8266
+  // yield to the SDK (WiFi) in 1ms slices instead of spinning until data is received (or timeout)
+  esp_delay(timeout, []()
+            { return PALA_SERIAL.available() == 0; }, 1);
+  avail = PALA_SERIAL.available();
+
+  // no RX callback on ESP8266, so answer is accounted when it is seen
+  if (avail)
+    stoveRxFrameReceived();
+
+  // RX buffer overflowed since last check
+  if (PALA_SERIAL.hasOverrun())
+    _stoveRxStats.overruns++;
+  if (PALA_SERIAL.hasRxError())
+    _stoveRxStats.errors++;
+#else
+  // sleep until UART driver signals received data (or timeout)
+  // (elapsed time is sampled once per iteration and compared by difference to stay correct across millis() rollover)
   unsigned long startmillis = millis();
-  while ((avail = PALA_SERIAL.available()) == 0 && (startmillis + timeout) > millis())
-    ;
+  unsigned long elapsed;
+  while ((avail = PALA_SERIAL.available()) == 0 && (elapsed = millis() - startmillis) < timeout)
+    xSemaphoreTake(_stoveRxSemaphore, pdMS_TO_TICKS(timeout - elapsed) + 1);
+#endif
+
+  if (firstWait && _stoveCmdRunning)
+  {
+    if (avail)
+      stoveRttSample(_stoveCmdClass, micros() - startMicros);
+    else if (shortened)
+      _stoveShortTimeoutHit = true;
+  }
 
   return avail;
 }
 size_t WPalaControl::myReadSerial(void *buf, size_t count) { return PALA_SERIAL.read((char *)buf, count); }
-size_t WPalaControl::myWriteSerial(const void *buf, size_t count) { return PALA_SERIAL.write((const uint8_t *)buf, count); }
+size_t WPalaControl::myWriteSerial(const void *buf, size_t count)
+{
+  // stove is offline, keep the bus quiet
+  if (isStoveBusBlocked())
+    return count;
+
+  TRACE_SCOPE("stoveWrite");
+
+  size_t written = PALA_SERIAL.write((const uint8_t *)buf, count);
+
+  // an answer is expected after this request
+  _stoveTxEndMicros = micros();
+  _stoveRxFrameExpected = true;
+  _stoveAwaitingAnswer = true;
+
+  return written;
+}
 int WPalaControl::myDrainSerial()
 {
   PALA_SERIAL.flush(); // On ESP, Serial.flush() is drain
+  _stoveTxEndMicros = micros();
   return 0;
 }
 int WPalaControl::myFlushSerial()
@@ -54,7 +170,241 @@ int WPalaControl::myFlushSerial()
     ; // flush RX buffer
   return 0;
 }
-void WPalaControl::myUSleep(unsigned long usecond) { delayMicroseconds(usecond); }
+void WPalaControl::myUSleep(unsigned long usecond)
+{
+  // stove is offline, no need to respect bus timings
+  if (isStoveBusBlocked())
+    return;
+
+  delayMicroseconds(usecond);
+}
+
+// Stove round trip time estimation --------
+unsigned long WPalaControl::stoveRto(StoveCmdClass cmdClass)
+{
+  const StoveRttEstimate &rtt = _stoveRtt[cmdClass];
+
+  // not enough samples to trust the estimation
+  if (rtt.samples < STOVE_RTO_MIN_SAMPLES)
+    return 0;
+
+  // RTO = SRTT + 4 * RTTVAR (in ms, rounded up)
+  unsigned long rto = (rtt.srtt + 4 * rtt.rttvar + 999) / 1000;
+
+  return (rto < STOVE_RTO_MIN) ? STOVE_RTO_MIN : rto;
+}
+
+void WPalaControl::stoveRttSample(StoveCmdClass cmdClass, uint32_t rtt)
+{
+  StoveRttEstimate &estimate = _stoveRtt[cmdClass];
+
+  if (!estimate.samples)
+  {
+    estimate.srtt = rtt;
+    estimate.rttvar = rtt / 2;
+  }
+  else
+  {
+    uint32_t delta = (estimate.srtt > rtt) ? estimate.srtt - rtt : rtt - estimate.srtt;
+    estimate.rttvar = (3 * estimate.rttvar + delta) / 4;
+    estimate.srtt = (7 * estimate.srtt + rtt) / 8;
+  }
+
+  estimate.samples++;
+}
+
+// Stove circuit breaker functions ---------
+// Initialize stove communication (runs on stove bus task on ESP32)
+Palazzetti::CommandResult WPalaControl::initStove()
+{
+  LOG_SERIAL_PRINT(F("Connecting to Stove..."));
+
+  StoveBusLock stoveBusLock(this);
+  StoveCmdScope stoveCmdScope(this, StoveCmdBulkRead);
+
+  Palazzetti::CommandResult cmdRes;
+  cmdRes = _Pala.initialize(
+      std::bind(&WPalaControl::myOpenSerial, this, std::placeholders::_1),
+      std::bind(&WPalaControl::myCloseSerial, this),
+      std::bind(&WPalaControl::mySelectSerial, this, std::placeholders::_1),
+      std::bind(&WPalaControl::myReadSerial, this, std::placeholders::_1, std::placeholders::_2),
+      std::bind(&WPalaControl::myWriteSerial, this, std::placeholders::_1, std::placeholders::_2),
+      std::bind(&WPalaControl::myDrainSerial, this),
+      std::bind(&WPalaControl::myFlushSerial, this),
+      std::bind(&WPalaControl::myUSleep, this, std::placeholders::_1),
+      _stoveHWV1);
+
+  if (cmdRes == Palazzetti::CommandResult::OK)
+  {
+    LOG_SERIAL_PRINTLN(F("Stove connected"));
+    char SN[28];
+    _Pala.getSN(&SN);
+    LOG_SERIAL_PRINTF_P(PSTR("Stove Serial Number: %s\n"), SN);
+  }
+  else
+    LOG_SERIAL_PRINTLN(F("Stove connection failed"));
+
+  return cmdRes;
+}
+
+void WPalaControl::stoveAttachRun()
+{
+  switch (_stoveAttachState)
+  {
+  case StoveDetectHW:
+    // wait for the pullup of hw version detection pin to settle
+    if (millis() - _stoveAttachMillis < 2)
+      break;
+
+    _stoveHWV1 = (digitalRead(HW_DETECT_PIN) == HIGH);
+    LOG_SERIAL_PRINTLN(_stoveHWV1 ? F("Stove HW1 detected") : F("Stove HW2 detected"));
+    _stoveAttachState = StoveInit;
+    break;
+
+  case StoveInit:
+  {
+    // if stove is offline, retries are done by circuit breaker probes
+    if (_stoveOffline)
+      break;
+
+    // initialization waits for the stove library timeout, so it runs on the stove bus
+    // (result is handled by stoveAttachResult)
+    PalaCmdJob *job = new PalaCmdJob;
+    job->type = StoveJobAttach;
+    job->cmd = F("INIT");
+    job->lane = StoveLaneInteractive;
+    job->submitMillis = millis();
+
+    if (submitPalaCmdJob(job))
+      _stoveAttachState = StoveInitQueued;
+    else
+      delete job; // queue is full, retry at next run
+    break;
+  }
+
+  case StoveInitQueued:
+  case StoveAttached:
+    break;
+  }
+}
+
+void WPalaControl::stoveAttachResult(Palazzetti::CommandResult cmdRes)
+{
+  // attach was restarted (or stove was attached by a probe) meanwhile
+  if (_stoveAttachState != StoveInitQueued)
+    return;
+
+  if (cmdRes == Palazzetti::CommandResult::OK)
+  {
+    _stoveAttachState = StoveAttached;
+    _needPublish = true; // publish stove data as soon as it is attached
+    return;
+  }
+
+  _stoveAttachState = StoveInit;
+
+  // no answer at all, don't wait for more failures to go offline
+  _stoveFailures = STOVE_BREAKER_THRESHOLD - 1;
+  stoveBusResult(false);
+}
+
+void WPalaControl::stoveBusResult(bool success)
+{
+  // once offline, only a successful probe can bring the stove back
+  if (_stoveOffline)
+    return;
+
+  if (success)
+  {
+    _stoveFailures = 0;
+    return;
+  }
+
+  if (++_stoveFailures < STOVE_BREAKER_THRESHOLD)
+    return;
+
+  LOG_SERIAL_PRINTLN(F("Stove offline"));
+
+  _stoveOffline = true;
+  _stoveProbeBackoff = STOVE_BREAKER_MIN_BACKOFF;
+  scheduleStoveProbe();
+
+  if (_ha.protocol == HA_PROTO_MQTT)
+    mqttPublishStoveConnected(false);
+}
+
+void WPalaControl::scheduleStoveProbe()
+{
+#ifdef ESP8266
+  _stoveProbeTicker.once(_stoveProbeBackoff, [this]()
+                         { this->_needStoveProbe = true; });
+#else
+  _stoveProbeTicker.once<typeof this>(_stoveProbeBackoff, [](typeof this palaControl)
+                                      { palaControl->_needStoveProbe = true; }, this);
+#endif
+}
+
+void WPalaControl::stoveProbe()
+{
+  // probe runs on the stove bus, result is handled by stoveProbeResult
+  PalaCmdJob *job = new PalaCmdJob;
+  job->type = StoveJobProbe;
+  job->cmd = F("PROBE");
+  job->lane = StoveLaneInteractive;
+  job->submitMillis = millis();
+
+  if (submitPalaCmdJob(job))
+    return;
+
+  // queue is full, retry at next run
+  delete job;
+  _needStoveProbe = true;
+}
+
+// Stove bus half of a probe (runs on stove bus task on ESP32)
+Palazzetti::CommandResult WPalaControl::stoveBusProbe()
+{
+  Palazzetti::CommandResult cmdRes;
+
+  StoveBusLock stoveBusLock(this);
+
+  // half-open : let one request reach the stove
+  _stoveProbing = true;
+  if (_Pala.isInitialized())
+  {
+    StoveCmdScope stoveCmdScope(this, StoveCmdRead);
+    uint16_t STATUS, LSTATUS, FSTATUS;
+    cmdRes = _Pala.getStatus(&STATUS, &LSTATUS, &FSTATUS);
+  }
+  else
+    cmdRes = initStove();
+  _stoveProbing = false;
+
+  return cmdRes;
+}
+
+void WPalaControl::stoveProbeResult(Palazzetti::CommandResult cmdRes)
+{
+  if (cmdRes == Palazzetti::CommandResult::OK)
+  {
+    LOG_SERIAL_PRINTLN(F("Stove back online"));
+
+    _stoveOffline = false;
+    _stoveFailures = 0;
+    _stoveAttachState = StoveAttached; // probe initializes stove communication if needed
+
+    if (_ha.protocol == HA_PROTO_MQTT)
+      mqttPublishStoveConnected(true);
+
+    _needPublish = true; // refresh stove data immediately
+  }
+  else
+  {
+    // exponential backoff before next probe
+    _stoveProbeBackoff = min(_stoveProbeBackoff * 2, STOVE_BREAKER_MAX_BACKOFF);
+    scheduleStoveProbe();
+  }
+}
 
 void WPalaControl::mqttConnectedCallback(MQTTMan *mqttMan, bool firstConnection)
 {
@@ -109,7 +459,6 @@ void WPalaControl::mqttCallback(char *topic, uint8_t *payload, unsigned int leng
   if (cmdTopic == topic)
   {
     String cmd;
-    String strJson;
 
     // convert payload to String cmd
     cmd.concat((char *)payload, length);
@@ -117,15 +466,22 @@ void WPalaControl::mqttCallback(char *topic, uint8_t *payload, unsigned int leng
     // replace '+' by ' '
     cmd.replace('+', ' ');
 
-    // execute Palazzetti command
-    executePalaCmd(cmd, strJson, true);
+    // slider writes are merged during a short window
+    if (coalescePalaWrite(cmd))
+      return;
 
-    // publish json result to MQTT
-    String baseTopic = _ha.mqtt.generic.baseTopic;
-    MQTTMan::prepareTopic(baseTopic);
-    String resTopic(baseTopic);
-    resTopic += F("result");
-    _mqttMan.publish(resTopic.c_str(), strJson.c_str());
+    // queue Palazzetti command : controls are served before any other stove request
+    // result is published by processStoveBusResults
+    StoveLane lane = (cmd.startsWith(F("SET ")) || cmd.startsWith(F("CMD "))) ? StoveLaneInteractive : StoveLaneUser;
+    if (!submitPalaCmd(cmd, lane, true, true))
+    {
+      // queue is full (stove is not answering fast enough), answer with an error
+      String baseTopic = _ha.mqtt.generic.baseTopic;
+      MQTTMan::prepareTopic(baseTopic);
+      String resTopic(baseTopic);
+      resTopic += F("result");
+      _mqttMan.publish(resTopic.c_str(), palaCmdError(cmd, F("Stove bus busy")).c_str());
+    }
   }
 
   // if topic ends with "/update/install"
@@ -155,7 +511,7 @@ void WPalaControl::mqttCallback(char *topic, uint8_t *payload, unsigned int leng
         lastProgressPublish = millis();
 
         uint8_t percent = (progress * 100) / total;
-        LOG_SERIAL_PRINTF_P(PSTR("Progress: %d%%\n"), percent);
+        LOG_DEBUG_PRINTF_P(PSTR("Progress: %d%%\n"), percent);
         String payload = String(F("{\"update_percentage\":")) + percent + '}';
         _mqttMan.publish(resTopic.c_str(), payload.c_str(), true);
       };
@@ -189,6 +545,9 @@ void WPalaControl::mqttPublishStoveConnected(bool stoveConnected)
 
 bool WPalaControl::mqttPublishData(const String &baseTopic, const String &palaCategory, const JsonDocument &jsonDoc)
 {
+  HEAP_SCOPE(HeapMqttPublish);
+  TRACE_SCOPE("mqttPublishData");
+
   bool res = false;
   if (_mqttMan.connected())
   {
@@ -238,11 +597,66 @@ bool WPalaControl::mqttPublishData(const String &baseTopic, const String &palaCa
   return res;
 }
 
+void WPalaControl::hassDiscoveryRead()
+{
+  // read still running, or stove offline (discovery is retried once it is back)
+  if (_hassDiscoveryReadPending || _stoveOffline)
+    return;
+
+  // after user commands, result is kept by processStoveBusResults
+  PalaCmdJob *job = new PalaCmdJob;
+  job->type = StoveJobDiscovery;
+  job->cmd = F("DISCOVERY");
+  job->lane = StoveLaneBackground;
+  job->submitMillis = millis();
+
+  if (submitPalaCmdJob(job))
+    _hassDiscoveryReadPending = true;
+  else
+    delete job;
+}
+
+// Stove bus half of discovery : read static data and all status (runs on stove bus task on ESP32)
+void WPalaControl::stoveBusDiscovery(PalaCmdJob *job)
+{
+  StoveBusLock stoveBusLock(this);
+  StoveCmdScope stoveCmdScope(this, StoveCmdBulkRead);
+
+  job->discovery.reset(new HassDiscoveryData);
+  HassDiscoveryData &stove = *job->discovery;
+
+  // read static data from stove
+  byte SNCHK;
+  uint16_t FLUID;
+  job->result.cmdSuccess = _Pala.getStaticData(&stove.SN, &SNCHK, nullptr, &stove.MOD, &stove.VER, nullptr, &stove.FWDATE, &FLUID, &stove.SPLMIN, &stove.SPLMAX, &stove.UICONFIG, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, &stove.MAINTPROBE, &stove.STOVETYPE, &stove.FAN2TYPE, &stove.FAN2MODE, nullptr, nullptr, nullptr, nullptr, nullptr);
+  if (job->result.cmdSuccess != Palazzetti::CommandResult::OK)
+    return;
+
+  // read all status from stove
+  bool refreshStatus = false;
+  unsigned long currentMillis = millis();
+  if ((currentMillis - _lastAllStatusRefreshMillis) > 15000UL) // refresh AllStatus data if it's 15sec old
+    refreshStatus = true;
+  job->result.cmdSuccess = _Pala.getAllStatus(false, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, &stove.SETP, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, &stove.FANLMINMAX, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+  if (job->result.cmdSuccess == Palazzetti::CommandResult::OK && refreshStatus)
+    _lastAllStatusRefreshMillis = currentMillis;
+}
+
 bool WPalaControl::mqttPublishHassDiscovery()
 {
   if (!_mqttMan.connected())
     return false;
 
+  // stove entities depend on stove data which are read through the stove bus first
+  if (_Pala.isInitialized() && !_hassDiscoveryData)
+  {
+    hassDiscoveryRead();
+    return false;
+  }
+
+  HEAP_SCOPE(HeapDiscovery);
+  TRACE_SCOPE("mqttPublishHassDiscovery");
+
   LOG_SERIAL_PRINTLN(F("Publish Home Assistant Discovery data"));
 
   // Helper lambda to prepare entity topic
@@ -327,35 +741,22 @@ bool WPalaControl::mqttPublishHassDiscovery()
 
   // ---------- Get Stove Device data ----------
 
-  if (!_Pala.isInitialized())
+  // stove is not initialized
+  if (!_hassDiscoveryData)
     return true;
 
-  // read static data from stove
-  char SN[28];
-  byte SNCHK;
-  uint16_t MOD, VER;
-  char FWDATE[11];
-  uint16_t FLUID;
-  uint16_t SPLMIN, SPLMAX;
-  byte UICONFIG;
-  byte MAINTPROBE;
-  byte STOVETYPE;
-  byte FAN2TYPE;
-  byte FAN2MODE;
-  if (Palazzetti::CommandResult::OK != _Pala.getStaticData(&SN, &SNCHK, nullptr, &MOD, &VER, nullptr, &FWDATE, &FLUID, &SPLMIN, &SPLMAX, &UICONFIG, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, &MAINTPROBE, &STOVETYPE, &FAN2TYPE, &FAN2MODE, nullptr, nullptr, nullptr, nullptr, nullptr))
-    return false;
-
-  // read all status from stove
-  bool refreshStatus = false;
-  unsigned long currentMillis = millis();
-  if ((currentMillis - _lastAllStatusRefreshMillis) > 15000UL) // refresh AllStatus data if it's 15sec old
-    refreshStatus = true;
-  float SETP;
-  uint16_t FANLMINMAX[6];
-  if (Palazzetti::CommandResult::OK != _Pala.getAllStatus(false, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, &SETP, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, &FANLMINMAX, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr))
-    return false;
-  else if (refreshStatus)
-    _lastAllStatusRefreshMillis = currentMillis;
+  // stove data read by stoveBusDiscovery
+  const char *SN = _hassDiscoveryData->SN;
+  uint16_t MOD = _hassDiscoveryData->MOD, VER = _hassDiscoveryData->VER;
+  const char *FWDATE = _hassDiscoveryData->FWDATE;
+  uint16_t SPLMIN = _hassDiscoveryData->SPLMIN, SPLMAX = _hassDiscoveryData->SPLMAX;
+  byte UICONFIG = _hassDiscoveryData->UICONFIG;
+  byte MAINTPROBE = _hassDiscoveryData->MAINTPROBE;
+  byte STOVETYPE = _hassDiscoveryData->STOVETYPE;
+  byte FAN2TYPE = _hassDiscoveryData->FAN2TYPE;
+  byte FAN2MODE = _hassDiscoveryData->FAN2MODE;
+  float SETP = _hassDiscoveryData->SETP;
+  const uint16_t *FANLMINMAX = _hassDiscoveryData->FANLMINMAX;
 
   // calculate flags (https://github.com/palazzetti/palazzetti-sdk-asset-parser-python/blob/main/palazzetti_sdk_asset_parser/data/asset_parser.json)
   bool hasSetPoint = (SETP != 0);
@@ -1106,6 +1507,9 @@ bool WPalaControl::mqttPublishHassDiscovery()
   // publish
   publishJson(topic, jsonDoc);
 
+  // stove data are read again for next discovery
+  _hassDiscoveryData.reset();
+
   return true;
 }
 
@@ -1224,16 +1628,50 @@ bool WPalaControl::mqttPublishUpdate()
   return true;
 }
 
-bool WPalaControl::executePalaCmd(const String &cmd, String &strJson, bool publish /* = false*/)
+// Execute the stove bus half of a command with adaptive timeout for reads (and retry a GET missed because of it)
+void WPalaControl::runPalaCmdOnBus(const String &cmd, PalaCmdResult &result)
+{
+  if (cmd.startsWith(F("SET ")) || cmd.startsWith(F("CMD ")))
+    _stoveCmdClass = StoveCmdWrite;
+  else if (cmd == F("GET ALLS") || cmd == F("GET STDT") || cmd == F("GET PARM") || cmd == F("GET HPAR") || cmd.startsWith(F("EXT ADRR")))
+    _stoveCmdClass = StoveCmdBulkRead;
+  else
+    _stoveCmdClass = StoveCmdRead;
+
+  _stoveCmdRunning = true;
+  // writes keep the library timeout : a late answer doesn't mean the stove didn't apply it,
+  // and they can't be retried safely (round trip time is still estimated for status)
+  _stoveAdaptiveTimeout = (_stoveCmdClass != StoveCmdWrite);
+  _stoveShortTimeoutHit = false;
+
+  executePalaCmdOnBus(cmd, result);
+
+  // answer may just be later than usual : retry read once with library timeout
+  if (result.cmdSuccess != Palazzetti::CommandResult::OK && _stoveShortTimeoutHit && cmd.startsWith(F("GET ")))
+  {
+    _stoveAdaptiveRetries++;
+    _stoveAdaptiveTimeout = false;
+    result = PalaCmdResult();
+    executePalaCmdOnBus(cmd, result);
+  }
+
+  _stoveAdaptiveTimeout = false;
+  _stoveCmdRunning = false;
+}
+
+// Stove bus half of a command : talk to the stove and fill result (runs on stove bus task on ESP32)
+void WPalaControl::executePalaCmdOnBus(const String &cmd, PalaCmdResult &result)
 {
-  bool cmdProcessed = false;                                                             // cmd has been processed
-  Palazzetti::CommandResult cmdSuccess = Palazzetti::CommandResult::COMMUNICATION_ERROR; // Palazzetti function calls successful
+  TRACE_SCOPE("executePalaCmdOnBus");
+
+  bool &cmdProcessed = result.cmdProcessed;                  // cmd has been processed
+  Palazzetti::CommandResult &cmdSuccess = result.cmdSuccess; // Palazzetti function calls successful
 
   // Prepare answer structure --------------------------------------------------
-  JsonDocument jsonDoc;
+  JsonDocument &jsonDoc = result.jsonDoc;
   JsonObject info = jsonDoc["INFO"].to<JsonObject>();
   JsonObject data = jsonDoc["DATA"].to<JsonObject>();
-  String palaCategory; // used to return data to the correct MQTT category (if needed)
+  String &palaCategory = result.palaCategory;
 
   // Parse parameters ----------------------------------------------------------
   byte cmdParamNumber = 0;
@@ -1272,8 +1710,8 @@ bool WPalaControl::executePalaCmd(const String &cmd, String &strJson, bool publi
 
       cmdParams[cmdParamNumber] = strCmdParams[cmdParamNumber].toInt();
 
-      // special case EXT ADRD and EXT ADWR (first parameter is an hexadecimal address)
-      if (cmdParamNumber == 0 && (cmd.startsWith(F("EXT ADRD ")) || cmd.startsWith(F("EXT ADWR "))))
+      // special case EXT ADRD, EXT ADRR and EXT ADWR (first parameter is an hexadecimal address)
+      if (cmdParamNumber == 0 && (cmd.startsWith(F("EXT ADRD ")) || cmd.startsWith(F("EXT ADRR ")) || cmd.startsWith(F("EXT ADWR "))))
         cmdParams[cmdParamNumber] = strtol(strCmdParams[cmdParamNumber].c_str(), NULL, 16);
 
       // verify convertion is successfull
@@ -2388,6 +2826,40 @@ bool WPalaControl::executePalaCmd(const String &cmd, String &strJson, bool publi
     }
   }
 
+  if (!cmdProcessed && cmd.startsWith(F("EXT ADRR")))
+  {
+    cmdProcessed = true;
+    palaCategory = F("ADRR");
+
+    // EXT ADRR <start address (hex)> <length> <same second parameter as EXT ADRD>
+    if (cmdParamNumber != 3)
+      info["MSG"] = String(F("Incorrect Parameter Number : ")) + cmdParamNumber;
+    else if (cmdParams[1] == 0 || cmdParams[1] > ADRR_MAX_JSON_LENGTH || (uint32_t)cmdParams[0] + cmdParams[1] > 0x10000)
+      info["MSG"] = String(F("Incorrect Parameter Value : ")) + strCmdParams[1];
+
+    if (info["MSG"].isNull())
+    {
+      String addrName;
+      uint16_t ADDR_DATA;
+      unsigned long lastReadMillis = 0;
+
+      // sequential reads in the same bus session
+      cmdSuccess = Palazzetti::CommandResult::OK;
+      for (uint16_t i = 0; i < cmdParams[1] && cmdSuccess == Palazzetti::CommandResult::OK; i++)
+      {
+        adrrReadPause(lastReadMillis);
+        cmdSuccess = _Pala.readData(cmdParams[0] + i, cmdParams[2], &ADDR_DATA);
+
+        if (cmdSuccess == Palazzetti::CommandResult::OK)
+        {
+          addrName = F("ADDR_");
+          addrName += String(cmdParams[0] + i, HEX);
+          data[addrName] = ADDR_DATA;
+        }
+      }
+    }
+  }
+
 #if DEVELOPPER_MODE
   // To be used only if you have good knowledge of Alpha motherboard
   if (!cmdProcessed && cmd.startsWith(F("EXT ADWR")))
@@ -2404,15 +2876,30 @@ bool WPalaControl::executePalaCmd(const String &cmd, String &strJson, bool publi
   }
 #endif
 
-  // Process result -----------------------------------------------------------
-
   // releases the unused memory before serialization
   jsonDoc.shrinkToFit();
+}
+
+// Publish half of a command : feed circuit breaker, publish data and serialize answer (runs in loop())
+bool WPalaControl::processPalaCmdResult(const String &cmd, PalaCmdResult &result, String &strJson, bool publish)
+{
+  bool cmdProcessed = result.cmdProcessed;
+  Palazzetti::CommandResult cmdSuccess = result.cmdSuccess;
+  JsonDocument &jsonDoc = result.jsonDoc;
+  JsonObject info = jsonDoc["INFO"];
+  JsonObject data = jsonDoc["DATA"];
+  const String &palaCategory = result.palaCategory;
+
+  // Process result -----------------------------------------------------------
 
   // if command has been processed
   if (cmdProcessed)
   {
 
+    // feed stove circuit breaker (parameters errors are not stove communication failures)
+    if (info["MSG"].isNull())
+      stoveBusResult(cmdSuccess == Palazzetti::CommandResult::OK);
+
     // if MQTT protocol is enabled then update connected topic to reflect stove connectivity
     if (_ha.protocol == HA_PROTO_MQTT)
       mqttPublishStoveConnected(cmdSuccess == Palazzetti::CommandResult::OK);
@@ -2425,11 +2912,18 @@ bool WPalaControl::executePalaCmd(const String &cmd, String &strJson, bool publi
       info["RSP"] = F("OK");
       jsonDoc["SUCCESS"] = true;
 
+      // keep values for history and metrics
+      _history.update(data);
+      updateStoveCache(data);
+
       if (publish && palaCategory.length() > 0)
       {
         String strData;
         serializeJson(data, strData);
         _eventSourceMan.eventSourceBroadcast(strData);
+#if WS_ENABLED
+        _webSocketMan.broadcast(strData);
+#endif
 
         String baseTopic = _ha.mqtt.generic.baseTopic;
         MQTTMan::prepareTopic(baseTopic);
@@ -2437,6 +2931,9 @@ bool WPalaControl::executePalaCmd(const String &cmd, String &strJson, bool publi
         if (_ha.protocol == HA_PROTO_MQTT && _haSendResult)
         {
           _haSendResult &= mqttPublishData(baseTopic, palaCategory, jsonDoc);
+
+          if (_haSendResult)
+            SystemState::markBootPhase(SystemState::BootFirstPublish);
         }
       }
     }
@@ -2448,7 +2945,7 @@ bool WPalaControl::executePalaCmd(const String &cmd, String &strJson, bool publi
       if (info["MSG"].isNull())
       {
         info["RSP"] = F("TIMEOUT");
-        info["MSG"] = F("Stove communication failed");
+        info["MSG"] = (_stoveOffline ? F("Stove offline") : F("Stove communication failed"));
       }
       else
         info["RSP"] = F("ERROR");
@@ -2468,23 +2965,1138 @@ bool WPalaControl::executePalaCmd(const String &cmd, String &strJson, bool publi
   }
 
   // serialize result to the provided strJson
-  serializeJson(jsonDoc, strJson);
+  {
+    TRACE_SCOPE("serializeJson");
+    serializeJson(jsonDoc, strJson);
+  }
 
   return jsonDoc["SUCCESS"].as<bool>();
 }
 
-void WPalaControl::publishTick()
+#if WS_ENABLED
+// WebSocket functions ---------------------
+// command is either plain text ("GET TMPS") or JSON ({"id":"1","command":"GET TMPS"})
+void WPalaControl::webSocketCommand(uint8_t clientNum, const char *payload, size_t length)
 {
-  LOG_SERIAL_PRINTLN(F("PublishTick"));
+  String cmd;
+  WsWaiter wsWaiter;
+  wsWaiter.session = _webSocketMan.session(clientNum);
 
-  // if MQTT protocol is enabled and connected then publish Core, Wifi and WPalaControl status
-  if (_ha.protocol == HA_PROTO_MQTT && _mqttMan.connected())
+  // JSON request ({"command":"GET STAT","id":"..."}) or raw command
+  JsonDocument jsonDoc;
+  if (length && payload[0] == '{' && !deserializeJson(jsonDoc, payload, length))
   {
-    String baseTopic = _ha.mqtt.generic.baseTopic;
-    MQTTMan::prepareTopic(baseTopic);
-    // remove the last char of baseTopic which is a '/'
-    baseTopic.remove(baseTopic.length() - 1);
-
+    wsWaiter.id = jsonDoc[F("id")].as<String>();
+    if (jsonDoc[F("command")].is<const char *>())
+      cmd = jsonDoc[F("command")].as<String>();
+  }
+  else
+    cmd.concat(payload, length);
+
+  // nothing to send to the stove
+  if (!cmd.length())
+  {
+    webSocketAnswer(wsWaiter, palaCmdError(F("UNKNOWN"), F("Missing command")));
+    return;
+  }
+
+  // replace '+' by ' '
+  cmd.replace('+', ' ');
+
+  // slider writes are merged during a short window (like MQTT ones), result is sent to every requester
+  if (coalescePalaWrite(cmd, &wsWaiter))
+    return;
+
+  // same queue as MQTT commands : controls are served before any other stove request
+  // result is sent by processStoveBusResults
+  PalaCmdJob *job = new PalaCmdJob;
+  job->cmd = cmd;
+  job->lane = (cmd.startsWith(F("SET ")) || cmd.startsWith(F("CMD "))) ? StoveLaneInteractive : StoveLaneUser;
+  job->publish = true;
+  job->submitMillis = millis();
+  job->wsWaiters[0] = wsWaiter;
+  job->wsWaiterCount = 1;
+
+  if (submitPalaCmdJob(job))
+    return;
+
+  // queue is full (stove is not answering fast enough), answer with an error
+  webSocketAnswer(wsWaiter, palaCmdError(cmd, F("Stove bus busy")));
+  delete job;
+}
+
+void WPalaControl::webSocketAnswer(const WsWaiter &wsWaiter, const String &strJson)
+{
+  JsonDocument answerDoc;
+  if (wsWaiter.id.length())
+    answerDoc[F("id")] = wsWaiter.id;
+  answerDoc[F("result")] = serialized(strJson);
+
+  String strAnswer;
+  serializeJson(answerDoc, strAnswer);
+  // dropped if client disconnected (and its slot may be used by another one) since the command was received
+  _webSocketMan.sendTo(wsWaiter.session, strAnswer);
+}
+#endif
+
+// Stove bus queue functions ---------------
+bool WPalaControl::submitPalaCmd(const String &cmd, StoveLane lane, bool publish, bool publishResult /* = false */, uint32_t cycle /* = 0 */)
+{
+  PalaCmdJob *job = new PalaCmdJob;
+  job->cmd = cmd;
+  job->publish = publish;
+  job->publishResult = publishResult;
+  job->lane = lane;
+  job->cycle = cycle;
+  job->submitMillis = millis();
+
+  if (submitPalaCmdJob(job))
+    return true;
+
+  delete job;
+  return false;
+}
+
+// background polling jobs are limited to their share of the stove bus
+bool WPalaControl::isStoveBusBackgroundJob(const PalaCmdJob *job)
+{
+  return job->lane == StoveLaneBackground && !job->statusWatch;
+}
+
+bool WPalaControl::submitPalaCmdJob(PalaCmdJob *job)
+{
+  // each job in flight has a slot reserved in results queue
+  // background polling has its own share of them to keep room for user commands
+  // (the single status watcher read is not limited so it can't make a publish cycle incomplete)
+  if (!_stoveBusAdmission.admit(isStoveBusBackgroundJob(job)))
+  {
+    LOG_SERIAL_PRINTF_P(PSTR("Stove bus busy : %s refused\n"), job->cmd.c_str());
+    return false;
+  }
+
+  _stoveBusRequests[job->lane].push(job);
+
+#ifndef ESP8266
+  // wake up stove bus task
+  xTaskNotifyGive(_stoveBusTask);
+#endif
+
+  return true;
+}
+
+// Keep a slider write for PALA_COALESCE_WINDOW_MS so following writes to the same register replace it
+// (wsWaiter is the WebSocket requester to answer, MQTT requests are answered on result topic)
+bool WPalaControl::coalescePalaWrite(const String &cmd, const WsWaiter *wsWaiter /* = nullptr */)
+{
+  CoalesceGroup group;
+
+  if (cmd.startsWith(F("SET SETP ")) || cmd.startsWith(F("SET STPF ")))
+    group = CoalesceSetpoint;
+  else if (cmd.startsWith(F("SET POWR ")))
+    group = CoalescePower;
+  else if (cmd.startsWith(F("SET RFAN ")))
+    group = CoalesceRoomFan;
+  else if (cmd.startsWith(F("SET FN3L ")))
+    group = CoalesceFan3;
+  else if (cmd.startsWith(F("SET FN4L ")))
+    group = CoalesceFan4;
+  else
+    return false;
+
+  PendingWrite &pendingWrite = _pendingWrites[group];
+
+  // no room left to remember this requester : send pending write now and start a new window
+  if (wsWaiter && pendingWrite.wsWaiterCount == PALA_COALESCE_WS_WAITERS && !flushCoalescedWrite(pendingWrite))
+  {
+    // queue is full, pending write is replaced by this one anyway
+#if WS_ENABLED
+    String strError(palaCmdError(pendingWrite.cmd, F("Stove bus busy")));
+    for (byte i = 0; i < pendingWrite.wsWaiterCount; i++)
+      webSocketAnswer(pendingWrite.wsWaiters[i], strError);
+#endif
+    pendingWrite.count = 0;
+    pendingWrite.wsWaiterCount = 0;
+  }
+
+  // window starts with the first write, so a continuous drag still reaches the stove
+  if (!pendingWrite.count)
+    pendingWrite.firstMillis = millis();
+  else
+    _coalescedWrites++;
+
+  pendingWrite.cmd = cmd;
+  pendingWrite.count++;
+
+  if (wsWaiter)
+    pendingWrite.wsWaiters[pendingWrite.wsWaiterCount++] = *wsWaiter;
+  else
+    pendingWrite.publishResult = true;
+
+  return true;
+}
+
+// queue a merged write, return false if queue is full
+bool WPalaControl::flushCoalescedWrite(PendingWrite &pendingWrite)
+{
+  PalaCmdJob *job = new PalaCmdJob;
+  job->cmd = pendingWrite.cmd;
+  job->publish = true;
+  job->publishResult = pendingWrite.publishResult;
+  job->lane = StoveLaneInteractive;
+  job->submitMillis = pendingWrite.firstMillis;
+  job->coalesced = pendingWrite.count;
+  for (byte i = 0; i < pendingWrite.wsWaiterCount; i++)
+    job->wsWaiters[i] = std::move(pendingWrite.wsWaiters[i]);
+  job->wsWaiterCount = pendingWrite.wsWaiterCount;
+
+  if (!submitPalaCmdJob(job))
+  {
+    // give requesters back to the pending write
+    for (byte i = 0; i < job->wsWaiterCount; i++)
+      pendingWrite.wsWaiters[i] = std::move(job->wsWaiters[i]);
+    delete job;
+    return false;
+  }
+
+  pendingWrite.cmd = String();
+  pendingWrite.count = 0;
+  pendingWrite.publishResult = false;
+  pendingWrite.wsWaiterCount = 0;
+  return true;
+}
+
+void WPalaControl::flushCoalescedWrites()
+{
+  for (PendingWrite &pendingWrite : _pendingWrites)
+  {
+    if (!pendingWrite.count || millis() - pendingWrite.firstMillis < PALA_COALESCE_WINDOW_MS)
+      continue;
+
+    // queue is full, retry at next run
+    flushCoalescedWrite(pendingWrite);
+  }
+}
+
+bool WPalaControl::popNextStoveJob(PalaCmdJob *&job)
+{
+  // highest lane first : a polling cycle (or a memory dump) is preempted between two of its commands
+  for (byte lane = 0; lane < StoveLaneCount; lane++)
+  {
+    if (_stoveBusResumedJob && _stoveBusResumedJob->lane == lane)
+    {
+      job = _stoveBusResumedJob;
+      _stoveBusResumedJob = nullptr;
+      return true;
+    }
+    if (_stoveBusRequests[lane].pop(job))
+      return true;
+  }
+
+  return false;
+}
+
+// return false if job needs more stove bus time (memory dump), it is then resumed by the next popNextStoveJob
+bool WPalaControl::stoveBusProcessJob(PalaCmdJob *job)
+{
+  switch (job->type)
+  {
+  case StoveJobCommand:
+    // a command of the same cycle already failed, don't insist
+    if (job->cycle && job->cycle == _stoveBusFailedCycle)
+    {
+      job->skipped = true;
+      break;
+    }
+
+    {
+      StoveBusLock stoveBusLock(this);
+      runPalaCmdOnBus(job->cmd, job->result);
+    }
+
+    if (job->result.cmdSuccess != Palazzetti::CommandResult::OK)
+      _stoveBusFailedCycle = job->cycle;
+    break;
+
+  case StoveJobAttach:
+    job->result.cmdSuccess = initStove();
+    break;
+
+  case StoveJobProbe:
+    job->result.cmdSuccess = stoveBusProbe();
+    break;
+
+  case StoveJobDiscovery:
+    stoveBusDiscovery(job);
+    break;
+
+  case StoveJobBackup:
+    stoveBusBackup(job);
+    break;
+
+  case StoveJobRestore:
+    stoveBusRestore(job);
+    break;
+
+  case StoveJobDump:
+    if (!stoveBusDumpStep(*job->dump))
+    {
+      _stoveBusResumedJob = job;
+      return false;
+    }
+    break;
+  }
+
+  _stoveBusResults.push(job);
+  return true;
+}
+
+// read next address of a memory dump (if the stove panel had its share of the bus), return true once complete
+bool WPalaControl::stoveBusDumpStep(AdrrDump &dump)
+{
+  StoveBusLock stoveBusLock(this);
+  StoveCmdScope stoveCmdScope(this, StoveCmdRead);
+
+  return dump.step(millis(), [this, &dump](uint16_t address, uint16_t &value)
+                   { return _Pala.readData(address, dump.readParam, &value) == Palazzetti::CommandResult::OK; });
+}
+
+void WPalaControl::stoveBusRun()
+{
+#ifdef ESP8266
+  // no dedicated task : execute one queued command (or one memory dump read) per loop
+  PalaCmdJob *job;
+  if (popNextStoveJob(job))
+    stoveBusProcessJob(job);
+#endif
+}
+
+#ifndef ESP8266
+void WPalaControl::stoveBusTask(void *pvParameters)
+{
+  WPalaControl *palaControl = (WPalaControl *)pvParameters;
+  PalaCmdJob *job;
+
+  for (;;)
+  {
+    // sleep until commands are queued (or until a memory dump can read its next address)
+    TickType_t wait = portMAX_DELAY;
+    if (palaControl->_stoveBusResumedJob)
+      wait = pdMS_TO_TICKS(palaControl->_stoveBusResumedJob->dump->nextReadDelay(millis())) + 1;
+    ulTaskNotifyTake(pdTRUE, wait);
+
+    while (palaControl->popNextStoveJob(job))
+      if (!palaControl->stoveBusProcessJob(job))
+        break; // memory dump waits for its next read, lower lanes wait for its end
+  }
+}
+#endif
+
+void WPalaControl::processStoveBusResults()
+{
+  PalaCmdJob *job;
+  while (_stoveBusResults.pop(job))
+  {
+    if (job->cycle)
+      _publishCycleJobsPending--;
+
+    if (job->type == StoveJobAttach)
+      stoveAttachResult(job->result.cmdSuccess);
+    else if (job->type == StoveJobProbe)
+      stoveProbeResult(job->result.cmdSuccess);
+    else if (job->type == StoveJobDiscovery)
+    {
+      _hassDiscoveryReadPending = false;
+      stoveBusResult(job->result.cmdSuccess == Palazzetti::CommandResult::OK);
+      if (job->result.cmdSuccess == Palazzetti::CommandResult::OK)
+        _hassDiscoveryData = std::move(job->discovery);
+    }
+    else if (job->type == StoveJobBackup)
+      sendPalaParamsBackup(job);
+    else if (job->type == StoveJobRestore)
+    {
+      stoveBusResult(job->result.cmdSuccess == Palazzetti::CommandResult::OK);
+
+      String strJson;
+      serializeJson(job->result.jsonDoc, strJson);
+      sendDeferredResponse(job->httpClient, F("text/json"), strJson.c_str(), strJson.length());
+    }
+    else if (job->type == StoveJobDump)
+      sendPalaMemoryDump(job);
+    else if (job->statusWatch)
+    {
+      // watcher reads only feed the circuit breaker and status transitions detection
+      // (history, metrics cache and MQTT are refreshed by the publish cycle)
+      _statusWatchPending = false;
+      stoveBusResult(job->result.cmdSuccess == Palazzetti::CommandResult::OK);
+      if (job->result.cmdSuccess == Palazzetti::CommandResult::OK)
+        statusWatchResult(job->result.jsonDoc);
+    }
+    else if (!job->skipped)
+    {
+      // polling status read is also used to detect status transitions
+      if (job->cmd == F("GET STAT") && job->result.cmdSuccess == Palazzetti::CommandResult::OK)
+        statusWatchResult(job->result.jsonDoc);
+
+      // one answer for all merged requests
+      if (job->coalesced > 1)
+        job->result.jsonDoc["INFO"]["COALESCED"] = job->coalesced;
+
+      String strJson;
+      processPalaCmdResult(job->cmd, job->result, strJson, job->publish);
+
+      // publish json result to MQTT
+      if (job->publishResult)
+      {
+        String resTopic = _ha.mqtt.generic.baseTopic;
+        MQTTMan::prepareTopic(resTopic);
+        resTopic += F("result");
+        _mqttMan.publish(resTopic.c_str(), strJson.c_str());
+      }
+
+#if WS_ENABLED
+      // answer to the WebSocket clients with their correlation id
+      for (byte i = 0; i < job->wsWaiterCount; i++)
+        webSocketAnswer(job->wsWaiters[i], strJson);
+#endif
+
+      // answer to the HTTP or UDP requesters waiting for it
+      if (job->httpAnswer)
+        sendDeferredResponse(job->httpClient, F("text/json"), strJson.c_str(), strJson.length());
+      if (job->udpAnswer)
+        udpCachedAnswerResult(*job->udpAnswer, strJson, job->result.cmdSuccess == Palazzetti::CommandResult::OK);
+
+      // measure Home Assistant controls responsiveness
+      if (job->lane == StoveLaneInteractive)
+      {
+        uint32_t latency = millis() - job->submitMillis;
+        _cmdAckLast = latency;
+        if (latency > _cmdAckMax)
+          _cmdAckMax = latency;
+        _cmdAckTotal += latency;
+        _cmdAckCount++;
+      }
+    }
+
+    _stoveBusAdmission.release(isStoveBusBackgroundJob(job));
+    delete job;
+  }
+}
+
+// Status watcher functions ---------------
+void WPalaControl::statusWatchRun()
+{
+  // stove not ready or previous read still running
+  if (_stoveAttachState != StoveAttached || _stoveOffline || _statusWatchPending)
+    return;
+
+  // a polling cycle is running, its own status read will be used
+  if (_publishCycleJobsPending)
+    return;
+
+  PalaCmdJob *job = new PalaCmdJob;
+  job->cmd = F("GET STAT");
+  job->lane = StoveLaneBackground;
+  job->submitMillis = millis();
+  job->statusWatch = true;
+
+  if (submitPalaCmdJob(job))
+    _statusWatchPending = true;
+  else
+    delete job;
+}
+
+void WPalaControl::statusWatchResult(const JsonDocument &jsonDoc)
+{
+  uint16_t status[3] = {jsonDoc["DATA"]["STATUS"].as<uint16_t>(), jsonDoc["DATA"]["LSTATUS"].as<uint16_t>(), jsonDoc["DATA"]["FSTATUS"].as<uint16_t>()};
+
+  bool changed = _statusKnown && memcmp(status, _lastStatus, sizeof(status));
+  bool first = !_statusKnown;
+
+  JsonDocument eventDoc;
+  if (changed)
+  {
+    const char *names[3] = {"STATUS", "LSTATUS", "FSTATUS"};
+    for (byte i = 0; i < 3; i++)
+    {
+      eventDoc[names[i]] = status[i];
+      eventDoc[String(F("OLD_")) + names[i]] = _lastStatus[i];
+    }
+  }
+
+  memcpy(_lastStatus, status, sizeof(status));
+  _statusKnown = true;
+
+  if (first || !changed)
+    return;
+
+  LOG_SERIAL_PRINTF_P(PSTR("Stove status changed to %u/%u/%u\n"), status[0], status[1], status[2]);
+
+  String strEvent;
+  serializeJson(eventDoc, strEvent);
+
+  // push event immediately
+  _eventSourceMan.eventSourceBroadcast(strEvent, F("event"));
+#if WS_ENABLED
+  _webSocketMan.broadcast(strEvent, F("event"));
+#endif
+
+  if (_ha.protocol == HA_PROTO_MQTT && _mqttMan.connected())
+  {
+    String eventTopic = _ha.mqtt.generic.baseTopic;
+    MQTTMan::prepareTopic(eventTopic);
+    eventTopic += F("event");
+    _mqttMan.publish(eventTopic.c_str(), strEvent.c_str());
+  }
+
+  // then refresh all stove data
+  _needPublish = true;
+}
+
+void WPalaControl::adrrReadPause(unsigned long &lastReadMillis)
+{
+  // let the stove panel use the bus between two memory reads
+  unsigned long elapsed = millis() - lastReadMillis;
+  if (lastReadMillis && elapsed < ADRR_READ_INTERVAL)
+    delay(ADRR_READ_INTERVAL - elapsed); // delay yields to WiFi stack
+  else
+    yield();
+
+  lastReadMillis = millis();
+}
+
+void WPalaControl::dumpPalaMemory(const String &cmd, WebServer &server)
+{
+  // BKP ADRR <start address (hex)> <length> <same second parameter as EXT ADRD> <BIN|HEX>
+  String params(cmd.substring(9));
+  params.trim();
+
+  String strParams[4];
+  byte paramNumber = 0;
+  while (params.length() && paramNumber < 4)
+  {
+    int pos = params.indexOf(' ');
+    strParams[paramNumber++] = (pos == -1 ? params : params.substring(0, pos));
+    params = (pos == -1 ? String() : params.substring(pos + 1));
+  }
+
+  uint16_t startAddr = strtol(strParams[0].c_str(), NULL, 16);
+  long length = strParams[1].toInt();
+  uint16_t readParam = strParams[2].toInt();
+  bool hexOutput = (strParams[3] == F("HEX"));
+
+  String errorMsg;
+  if (paramNumber != 4 || params.length())
+    errorMsg = String(F("Incorrect Parameter Number : ")) + paramNumber;
+  else if (length <= 0 || length > ADRR_MAX_DUMP_LENGTH || (uint32_t)startAddr + length > 0x10000)
+    errorMsg = String(F("Incorrect Parameter Value : ")) + strParams[1];
+  else if (!hexOutput && strParams[3] != F("BIN"))
+    errorMsg = String(F("Incorrect File Type : ")) + strParams[3];
+
+  if (!errorMsg.length())
+  {
+    // dump runs on the stove bus between other commands, answer is sent by processStoveBusResults once it is complete
+    PalaCmdJob *job = new PalaCmdJob;
+    job->type = StoveJobDump;
+    job->cmd = F("BKP ADRR");
+    job->lane = StoveLaneUser;
+    job->submitMillis = millis();
+    job->dump.reset(new AdrrDump(startAddr, length, readParam, hexOutput, ADRR_READ_INTERVAL));
+    job->httpClient = server.client();
+
+    if (submitPalaCmdJob(job))
+      return;
+
+    delete job;
+    errorMsg = F("Stove bus busy");
+  }
+
+  SERVER_KEEPALIVE_FALSE()
+  server.send(200, F("text/json"), palaCmdError(F("BKP ADRR"), errorMsg));
+}
+
+void WPalaControl::sendPalaMemoryDump(PalaCmdJob *job)
+{
+  AdrrDump &dump = *job->dump;
+
+  if (!dump.output())
+  {
+    String ret(palaCmdError(F("BKP ADRR"), F("Not enough memory")));
+    sendDeferredResponse(job->httpClient, F("text/json"), ret.c_str(), ret.length());
+    return;
+  }
+
+  // feed stove circuit breaker
+  stoveBusResult(!dump.failed());
+
+  // whole dump is buffered : a failure returns a clean error instead of a truncated file
+  if (dump.failed())
+  {
+    String ret(palaCmdError(F("BKP ADRR"), F("Stove communication failed"), true));
+    sendDeferredResponse(job->httpClient, F("text/json"), ret.c_str(), ret.length());
+    return;
+  }
+
+  String fileName(F("ADRR_"));
+  fileName += String(dump.startAddr(), HEX);
+  fileName += (dump.hexOutput() ? F(".txt") : F(".bin"));
+  sendDeferredResponse(job->httpClient, dump.hexOutput() ? F("text/plain") : F("application/octet-stream"), dump.output(), dump.outputLength(), fileName);
+}
+
+// Answer an HTTP request after its handler returned (used when the answer comes from the stove bus)
+void WPalaControl::sendDeferredResponse(WiFiClient &client, const __FlashStringHelper *contentType, const char *content, size_t length, const String &fileName /* = String() */)
+{
+  // client gave up waiting
+  if (!client.connected())
+    return;
+
+  String header(F("HTTP/1.1 200 OK\r\nContent-Type: "));
+  header += contentType;
+  header += F("\r\nContent-Length: ");
+  header += length;
+  if (fileName.length())
+  {
+    header += F("\r\nContent-Disposition: attachment; filename=\"");
+    header += fileName;
+    header += '"';
+  }
+  header += F("\r\nConnection: close\r\n\r\n");
+
+  client.write((const uint8_t *)header.c_str(), header.length());
+  client.write((const uint8_t *)content, length);
+  client.stop();
+}
+
+// Answer an HTTP command once the stove bus processed it
+void WPalaControl::submitHttpPalaCmd(const String &cmd, WebServer &server)
+{
+  // result is sent by processStoveBusResults
+  PalaCmdJob *job = new PalaCmdJob;
+  job->cmd = cmd;
+  job->lane = (cmd.startsWith(F("SET ")) || cmd.startsWith(F("CMD "))) ? StoveLaneInteractive : StoveLaneUser;
+  job->submitMillis = millis();
+  job->httpAnswer = true;
+  job->httpClient = server.client();
+
+  if (submitPalaCmdJob(job))
+    return;
+
+  delete job;
+
+  // queue is full (stove is not answering fast enough), answer with an error
+  SERVER_KEEPALIVE_FALSE()
+  server.send(200, F("text/json"), palaCmdError(cmd, F("Stove bus busy")));
+}
+
+void WPalaControl::backupPalaParams(const String &cmd, WebServer &server)
+{
+  // BKP PARM <CSV|JSON> backups parameters, BKP HPAR <CSV|JSON> backups hidden parameters
+  String backupCmd(cmd.substring(0, 8));
+  String strFileType(cmd.substring(9));
+
+  if (strFileType != F("CSV") && strFileType != F("JSON"))
+  {
+    SERVER_KEEPALIVE_FALSE()
+    server.send(200, F("text/json"), palaCmdError(backupCmd, String(F("Incorrect File Type : ")) + strFileType));
+    return;
+  }
+
+  // result is sent by processStoveBusResults
+  PalaCmdJob *job = new PalaCmdJob;
+  job->type = StoveJobBackup;
+  job->cmd = backupCmd;
+  job->lane = StoveLaneUser;
+  job->submitMillis = millis();
+  job->backupCsv = (strFileType == F("CSV"));
+  job->httpAnswer = true;
+  job->httpClient = server.client();
+
+  if (submitPalaCmdJob(job))
+    return;
+
+  delete job;
+
+  SERVER_KEEPALIVE_FALSE()
+  server.send(200, F("text/json"), palaCmdError(backupCmd, F("Stove bus busy")));
+}
+
+// Stove bus half of parameters backup (runs on stove bus task on ESP32)
+void WPalaControl::stoveBusBackup(PalaCmdJob *job)
+{
+  StoveBusLock stoveBusLock(this);
+  StoveCmdScope stoveCmdScope(this, StoveCmdBulkRead);
+
+  if (job->cmd == F("BKP HPAR"))
+  {
+    uint16_t hiddenParams[0x6F];
+    job->result.cmdSuccess = _Pala.getAllHiddenParameters(&hiddenParams);
+    if (job->result.cmdSuccess != Palazzetti::CommandResult::OK)
+      return;
+
+    JsonArray HPAR = job->result.jsonDoc[F("HPAR")].to<JsonArray>();
+    for (byte i = 0; i < 0x6F; i++)
+      HPAR.add(hiddenParams[i]);
+  }
+  else
+  {
+    byte params[0x6A];
+    job->result.cmdSuccess = _Pala.getAllParameters(&params);
+    if (job->result.cmdSuccess != Palazzetti::CommandResult::OK)
+      return;
+
+    JsonArray PARM = job->result.jsonDoc[F("PARM")].to<JsonArray>();
+    for (byte i = 0; i < 0x6A; i++)
+      PARM.add(params[i]);
+  }
+}
+
+void WPalaControl::sendPalaParamsBackup(PalaCmdJob *job)
+{
+  // feed stove circuit breaker
+  stoveBusResult(job->result.cmdSuccess == Palazzetti::CommandResult::OK);
+
+  if (job->result.cmdSuccess != Palazzetti::CommandResult::OK)
+  {
+    String ret(palaCmdError(job->cmd, F("Stove communication failed"), true));
+    sendDeferredResponse(job->httpClient, F("text/json"), ret.c_str(), ret.length());
+    return;
+  }
+
+  const char *key = job->cmd.c_str() + 4; // PARM or HPAR
+  JsonArrayConst values = job->result.jsonDoc[key].as<JsonArrayConst>();
+  String toReturn;
+
+  if (job->backupCsv)
+  {
+    toReturn += key;
+    toReturn += F(";VALUE\r\n");
+    byte i = 0;
+    for (JsonVariantConst value : values)
+      toReturn += String(i++) + ';' + value.as<uint16_t>() + '\r' + '\n';
+
+    sendDeferredResponse(job->httpClient, F("text/csv"), toReturn.c_str(), toReturn.length(), String(key) + F(".csv"));
+  }
+  else
+  {
+    serializeJson(job->result.jsonDoc, toReturn);
+    sendDeferredResponse(job->httpClient, F("text/json"), toReturn.c_str(), toReturn.length(), String(key) + F(".json"));
+  }
+}
+
+void WPalaControl::restorePalaParams(const String &cmd, const String &backup, WebServer &server)
+{
+  // RST PARM restores parameters, RST HPAR restores hidden parameters
+  bool hidden = (cmd == F("RST HPAR"));
+  const byte paramsCount = (hidden ? 0x6F : 0x6A);
+  const uint16_t maxValue = (hidden ? 0xFFFF : 0xFF);
+  const __FlashStringHelper *paramPrefix = (hidden ? F("HPAR") : F("PAR"));
+
+  // Prepare answer structure --------------------------------------------------
+  JsonDocument jsonDoc;
+  JsonObject info = jsonDoc["INFO"].to<JsonObject>();
+  JsonObject data = jsonDoc["DATA"].to<JsonObject>();
+  info["CMD"] = cmd.substring(0, 8);
+
+  // Parse backup file (-1 means parameter not present in the backup) ---------
+  std::unique_ptr<int32_t[]> wanted(new int32_t[0x6F]);
+  for (byte i = 0; i < 0x6F; i++)
+    wanted[i] = -1;
+
+  if (cmd != F("RST PARM") && cmd != F("RST HPAR"))
+    info["MSG"] = String(F("Incorrect Parameter Type : ")) + cmd.substring(4);
+  else if (backup.startsWith(F("{")))
+  {
+    // JSON backup : {"PARM":[...]} or {"HPAR":[...]}
+    JsonDocument backupDoc;
+    JsonArrayConst values;
+
+    if (deserializeJson(backupDoc, backup) || (values = backupDoc[hidden ? F("HPAR") : F("PARM")].as<JsonArrayConst>()).isNull())
+      info["MSG"] = F("Incorrect Backup File");
+    else if (values.size() > paramsCount)
+      info["MSG"] = String(F("Incorrect Parameter Number : ")) + values.size();
+    else
+    {
+      byte i = 0;
+      for (JsonVariantConst value : values)
+      {
+        if (!value.is<uint16_t>() || value.as<uint16_t>() > maxValue)
+        {
+          info["MSG"] = String(F("Incorrect Parameter Value : ")) + paramPrefix + i;
+          break;
+        }
+        wanted[i++] = value.as<uint16_t>();
+      }
+    }
+  }
+  else
+  {
+    // CSV backup : "PARM;VALUE\r\n" header followed by "index;value\r\n" lines
+    bool headerFound = false;
+    int lineStart = 0;
+    while (lineStart < (int)backup.length() && info["MSG"].isNull())
+    {
+      int lineEnd = backup.indexOf('\n', lineStart);
+      if (lineEnd == -1)
+        lineEnd = backup.length();
+
+      String line = backup.substring(lineStart, lineEnd);
+      line.trim();
+      lineStart = lineEnd + 1;
+
+      // skip empty lines
+      if (!line.length())
+        continue;
+
+      // first line must be the header of the table to restore
+      if (!headerFound)
+      {
+        if (line != (hidden ? F("HPAR;VALUE") : F("PARM;VALUE")))
+          info["MSG"] = F("Incorrect Backup File");
+        headerFound = true;
+        continue;
+      }
+
+      // index and value must only contain digits (and fit in their range before conversion)
+      int sepPos = line.indexOf(';');
+      bool digitsOnly = (sepPos > 0 && sepPos <= 3 && sepPos < (int)line.length() - 1 && (int)line.length() - sepPos - 1 <= 5);
+      for (int i = 0; digitsOnly && i < (int)line.length(); i++)
+        digitsOnly = (i == sepPos || isDigit(line[i]));
+
+      long index = line.substring(0, sepPos).toInt();
+      long value = line.substring(sepPos + 1).toInt();
+
+      if (!digitsOnly || index >= paramsCount || value > maxValue)
+        info["MSG"] = String(F("Incorrect Backup Line : ")) + line;
+      else
+        wanted[index] = value;
+    }
+
+    if (!headerFound && info["MSG"].isNull())
+      info["MSG"] = F("Incorrect Backup File");
+  }
+
+  // Parameters are compared and written by the stove bus ----------------------
+  // (result is sent by processStoveBusResults)
+  if (info["MSG"].isNull())
+  {
+    PalaCmdJob *job = new PalaCmdJob;
+    job->type = StoveJobRestore;
+    job->cmd = cmd;
+    job->lane = StoveLaneUser;
+    job->submitMillis = millis();
+    job->restoreValues = std::move(wanted);
+    job->httpAnswer = true;
+    job->httpClient = server.client();
+
+    if (submitPalaCmdJob(job))
+      return;
+
+    delete job;
+    info["MSG"] = F("Stove bus busy");
+  }
+
+  info["RSP"] = F("ERROR");
+  jsonDoc["SUCCESS"] = false;
+  data["NODATA"] = true;
+
+  String strJson;
+  serializeJson(jsonDoc, strJson);
+
+  SERVER_KEEPALIVE_FALSE()
+  server.send(200, F("text/json"), strJson);
+}
+
+// Stove bus half of parameters restore (runs on stove bus task on ESP32)
+void WPalaControl::stoveBusRestore(PalaCmdJob *job)
+{
+  bool hidden = (job->cmd == F("RST HPAR"));
+  const byte paramsCount = (hidden ? 0x6F : 0x6A);
+  const __FlashStringHelper *paramPrefix = (hidden ? F("HPAR") : F("PAR"));
+  const int32_t *wanted = job->restoreValues.get();
+
+  // Prepare answer structure --------------------------------------------------
+  JsonDocument &jsonDoc = job->result.jsonDoc;
+  JsonObject info = jsonDoc["INFO"].to<JsonObject>();
+  JsonObject data = jsonDoc["DATA"].to<JsonObject>();
+  info["CMD"] = job->cmd;
+
+  // Read current values and write back only the changed ones -----------------
+  Palazzetti::CommandResult cmdSuccess = Palazzetti::CommandResult::COMMUNICATION_ERROR;
+  uint16_t changed = 0, unchanged = 0, failed = 0;
+
+  {
+    StoveBusLock stoveBusLock(this);
+    StoveCmdScope stoveCmdScope(this, StoveCmdBulkRead);
+
+    uint16_t current[0x6F];
+
+    if (hidden)
+      cmdSuccess = _Pala.getAllHiddenParameters(&current);
+    else
+    {
+      byte params[0x6A];
+      cmdSuccess = _Pala.getAllParameters(&params);
+      for (byte i = 0; i < 0x6A; i++)
+        current[i] = params[i];
+    }
+
+    for (byte i = 0; i < paramsCount && cmdSuccess == Palazzetti::CommandResult::OK; i++)
+    {
+      if (wanted[i] == -1)
+        continue;
+
+      if (wanted[i] == current[i])
+      {
+        unchanged++;
+        continue;
+      }
+
+      JsonObject param = data[String(paramPrefix) + i].to<JsonObject>();
+      param["FROM"] = current[i];
+      param["TO"] = wanted[i];
+
+      // write then read back the parameter to verify it
+      uint16_t readBack = 0;
+      stoveCmdScope.setClass(StoveCmdWrite);
+      if (hidden)
+        cmdSuccess = _Pala.setHiddenParameter(i, wanted[i]);
+      else
+        cmdSuccess = _Pala.setParameter(i, wanted[i]);
+
+      stoveCmdScope.setClass(StoveCmdRead);
+      if (cmdSuccess == Palazzetti::CommandResult::OK && hidden)
+        cmdSuccess = _Pala.getHiddenParameter(i, &readBack);
+      else if (cmdSuccess == Palazzetti::CommandResult::OK)
+      {
+        byte paramValue = 0;
+        cmdSuccess = _Pala.getParameter(i, &paramValue);
+        readBack = paramValue;
+      }
+
+      if (cmdSuccess != Palazzetti::CommandResult::OK)
+      {
+        param["RES"] = F("TIMEOUT");
+        failed++;
+      }
+      else if (readBack != wanted[i])
+      {
+        param["RES"] = F("VERIFY FAILED");
+        param["READ"] = readBack;
+        failed++;
+      }
+      else
+      {
+        param["RES"] = F("OK");
+        changed++;
+      }
+    }
+  }
+
+  // Process result -----------------------------------------------------------
+  job->result.cmdSuccess = cmdSuccess;
+
+  if (cmdSuccess == Palazzetti::CommandResult::OK)
+  {
+    data["CHANGED"] = changed;
+    data["UNCHANGED"] = unchanged;
+    data["FAILED"] = failed;
+
+    info["RSP"] = F("OK");
+    jsonDoc["SUCCESS"] = (failed == 0);
+  }
+  else
+  {
+    info["RSP"] = F("TIMEOUT");
+    info["MSG"] = F("Stove communication failed");
+
+    jsonDoc["SUCCESS"] = false;
+    if (!changed && !failed)
+      data["NODATA"] = true;
+  }
+}
+
+// Metrics functions -----------------------
+// stove values exposed in OpenMetrics format (consecutive entries of the same family share TYPE line)
+typedef struct
+{
+  char key[14];
+  char family[40];
+  char label[16];
+  bool counter;
+  bool duration; // "h:mm" value converted to seconds
+} StoveMetric;
+
+static const StoveMetric stoveMetrics[] PROGMEM = {
+    {"T1", "palazzetti_temperature_celsius", "probe=\"T1\"", false, false},
+    {"T2", "palazzetti_temperature_celsius", "probe=\"T2\"", false, false},
+    {"T3", "palazzetti_temperature_celsius", "probe=\"T3\"", false, false},
+    {"T4", "palazzetti_temperature_celsius", "probe=\"T4\"", false, false},
+    {"T5", "palazzetti_temperature_celsius", "probe=\"T5\"", false, false},
+    {"SETP", "palazzetti_setpoint_celsius", "", false, false},
+    {"PWR", "palazzetti_power_level", "", false, false},
+    {"FDR", "palazzetti_feeder_rate", "", false, false},
+    {"STATUS", "palazzetti_status", "", false, false},
+    {"LSTATUS", "palazzetti_lstatus", "", false, false},
+    {"F1V", "palazzetti_fan_speed", "fan=\"F1V\"", false, false},
+    {"F2V", "palazzetti_fan_speed", "fan=\"F2V\"", false, false},
+    {"F2L", "palazzetti_fan_level", "fan=\"F2L\"", false, false},
+    {"F3L", "palazzetti_fan_level", "fan=\"F3L\"", false, false},
+    {"F4L", "palazzetti_fan_level", "fan=\"F4L\"", false, false},
+    {"F1RPM", "palazzetti_fan_rpm", "fan=\"F1\"", false, false},
+    {"DP_PRESS", "palazzetti_delta_pressure_pascal", "kind=\"actual\"", false, false},
+    {"DP_TARGET", "palazzetti_delta_pressure_pascal", "kind=\"target\"", false, false},
+    {"IGN", "palazzetti_ignitions", "", true, false},
+    {"IGNERRORS", "palazzetti_ignition_errors", "", true, false},
+    {"OVERTMPERRORS", "palazzetti_overtemperature_errors", "", true, false},
+    {"PQT", "palazzetti_pellet_consumed_kg", "", true, false},
+    {"POWERTIME", "palazzetti_power_time_seconds", "", true, true},
+    {"HEATTIME", "palazzetti_heat_time_seconds", "", true, true},
+    {"SERVICETIME", "palazzetti_service_time_seconds", "", true, true},
+    {"ONTIME", "palazzetti_on_time_seconds", "", true, true}};
+
+void WPalaControl::updateStoveCache(JsonObjectConst data)
+{
+  char key[sizeof(stoveMetrics[0].key)];
+  bool updated = false;
+
+  // only values exposed as metrics are kept (ALLS answer is too big to be cached)
+  for (const StoveMetric &metric : stoveMetrics)
+  {
+    memcpy_P(key, metric.key, sizeof(key));
+    JsonVariantConst value = data[key];
+    if (value.isNull())
+      continue;
+
+    _stoveCache[key] = value;
+    updated = true;
+  }
+
+  if (updated)
+    _stoveCacheMillis = millis();
+}
+
+void WPalaControl::streamMetrics(WebServer &server)
+{
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, F("application/openmetrics-text; version=1.0.0; charset=utf-8"), "");
+
+  String metrics;
+  metrics.reserve(1024);
+  char line[128];
+
+  // send accumulated lines once the chunk is big enough
+  auto flushMetrics = [&server, &metrics](bool force)
+  {
+    if (metrics.length() > (force ? 0 : 768))
+    {
+      server.sendContent(metrics);
+      metrics = "";
+    }
+  };
+
+  // Stove values -------------------------
+  StoveMetric metric;
+  char previousFamily[sizeof(metric.family)] = {0};
+  for (const StoveMetric &progmemMetric : stoveMetrics)
+  {
+    memcpy_P(&metric, &progmemMetric, sizeof(metric));
+    JsonVariantConst value = _stoveCache[metric.key];
+    if (value.isNull())
+      continue;
+
+    char strValue[16];
+    serializeJson(value, strValue, sizeof(strValue));
+
+    // durations are "h:mm" strings
+    if (metric.duration)
+    {
+      const char *strMinutes = strchr(strValue + 1, ':'); // skip opening quote
+      if (!strMinutes)
+        continue;
+      snprintf_P(strValue, sizeof(strValue), PSTR("%lu"), strtoul(strValue + 1, nullptr, 10) * 3600 + strtoul(strMinutes + 1, nullptr, 10) * 60);
+    }
+
+    if (strcmp(metric.family, previousFamily))
+    {
+      snprintf_P(line, sizeof(line), PSTR("# TYPE %s %s\n"), metric.family, metric.counter ? "counter" : "gauge");
+      metrics += line;
+      strcpy(previousFamily, metric.family);
+    }
+
+    snprintf_P(line, sizeof(line), PSTR("%s%s%s%s%s %s\n"), metric.family, metric.counter ? "_total" : "", metric.label[0] ? "{" : "", metric.label, metric.label[0] ? "}" : "", strValue);
+    metrics += line;
+
+    flushMetrics(false);
+  }
+
+  metrics += F("# TYPE palazzetti_up gauge\n");
+  metrics += F("palazzetti_up ");
+  metrics += (_stoveOffline || _stoveAttachState != StoveAttached) ? '0' : '1';
+  metrics += '\n';
+
+  if (_stoveCacheMillis)
+  {
+    snprintf_P(line, sizeof(line), PSTR("# TYPE palazzetti_data_age_seconds gauge\npalazzetti_data_age_seconds %lu\n"), (millis() - _stoveCacheMillis) / 1000);
+    metrics += line;
+  }
+
+  // Module health ------------------------
+  snprintf_P(line, sizeof(line), PSTR("# TYPE wpalacontrol_uptime_seconds gauge\nwpalacontrol_uptime_seconds %lu\n"), millis() / 1000);
+  metrics += line;
+  snprintf_P(line, sizeof(line), PSTR("# TYPE wpalacontrol_heap_free_bytes gauge\nwpalacontrol_heap_free_bytes %lu\n"), (unsigned long)ESP.getFreeHeap());
+  metrics += line;
+#if HEAP_MONITOR_ENABLED
+  snprintf_P(line, sizeof(line), PSTR("# TYPE wpalacontrol_heap_max_free_block_bytes gauge\nwpalacontrol_heap_max_free_block_bytes %lu\n"), (unsigned long)HeapMonitor::getMaxFreeBlock());
+  metrics += line;
+#endif
+  snprintf_P(line, sizeof(line), PSTR("# TYPE wpalacontrol_wifi_rssi_dbm gauge\nwpalacontrol_wifi_rssi_dbm %d\n"), WiFi.RSSI());
+  metrics += line;
+  flushMetrics(false);
+
+  snprintf_P(line, sizeof(line), PSTR("# TYPE wpalacontrol_stove_rx_frames counter\nwpalacontrol_stove_rx_frames_total %lu\n"), (unsigned long)_stoveRxStats.frames);
+  metrics += line;
+  snprintf_P(line, sizeof(line), PSTR("# TYPE wpalacontrol_stove_rx_errors counter\nwpalacontrol_stove_rx_errors_total %lu\n"), (unsigned long)_stoveRxStats.errors);
+  metrics += line;
+  snprintf_P(line, sizeof(line), PSTR("# TYPE wpalacontrol_stove_rx_overruns counter\nwpalacontrol_stove_rx_overruns_total %lu\n"), (unsigned long)_stoveRxStats.overruns);
+  metrics += line;
+  snprintf_P(line, sizeof(line), PSTR("# TYPE wpalacontrol_stove_adaptive_retries counter\nwpalacontrol_stove_adaptive_retries_total %lu\n"), (unsigned long)_stoveAdaptiveRetries);
+  metrics += line;
+  snprintf_P(line, sizeof(line), PSTR("# TYPE wpalacontrol_stove_consecutive_failures gauge\nwpalacontrol_stove_consecutive_failures %u\n"), _stoveFailures);
+  metrics += line;
+  flushMetrics(false);
+
+  if (_ha.protocol == HA_PROTO_MQTT)
+  {
+    metrics += F("# TYPE wpalacontrol_mqtt_connected gauge\nwpalacontrol_mqtt_connected ");
+    metrics += _mqttMan.connected() ? '1' : '0';
+    metrics += '\n';
+  }
+
+#if PERF_ENABLED
+  PerfMonitor::appendMetrics(metrics);
+#endif
+
+  metrics += F("# EOF\n");
+  flushMetrics(true);
+  server.sendContent(emptyString);
+}
+
+void WPalaControl::publishTick()
+{
+  TRACE_SCOPE("publishTick");
+
+  LOG_DEBUG_PRINTLN(F("PublishTick"));
+
+  // values received during previous cycle become a history sample
+  _history.commit();
+
+  // if MQTT protocol is enabled and connected then publish Core, Wifi and WPalaControl status
+  if (_ha.protocol == HA_PROTO_MQTT && _mqttMan.connected())
+  {
+    String baseTopic = _ha.mqtt.generic.baseTopic;
+    MQTTMan::prepareTopic(baseTopic);
+    // remove the last char of baseTopic which is a '/'
+    baseTopic.remove(baseTopic.length() - 1);
+
     JsonDocument doc;
     doc[getAppIdName(CoreApp)] = serialized(_applicationList[CoreApp]->getStatusJSON());
     doc[getAppIdName(WifiManApp)] = serialized(_applicationList[WifiManApp]->getStatusJSON());
@@ -2494,6 +4106,15 @@ void WPalaControl::publishTick()
     serializeJson(doc, strJson);
 
     _mqttMan.publish(baseTopic.c_str(), strJson.c_str(), true);
+
+#if PERF_ENABLED
+    // loop stages timing diagnostic (without histograms to keep payload small)
+    _mqttMan.publish((baseTopic + F("/diag/perf")).c_str(), PerfMonitor::generateJSON(false).c_str());
+#endif
+#if HEAP_MONITOR_ENABLED
+    // heap usage per subsystem diagnostic
+    _mqttMan.publish((baseTopic + F("/diag/heap")).c_str(), HeapMonitor::generateJSON().c_str());
+#endif
   }
 
   // array of commands to execute
@@ -2507,48 +4128,160 @@ void WPalaControl::publishTick()
       F("GET POWR"),
       F("GET DPRS")};
 
+  // previous publish cycle is still running (stove is slow to answer)
+  // (a pending status watcher read doesn't delay the cycle)
+  if (_publishCycleJobsPending)
+    return;
+
+  // whole cycle must fit : a cycle without its tail would leave values unpublished
+  // (user commands in flight don't reduce background share, this only happens when background slots are still busy)
+  if (_stoveBusAdmission.available(true) < sizeof(cmdList) / sizeof(cmdList[0]))
+  {
+    _stoveBusAdmission.refuse(sizeof(cmdList) / sizeof(cmdList[0]));
+    LOG_SERIAL_PRINTLN(F("Stove bus busy : publish cycle refused"));
+    return;
+  }
+
   // initialize _haSendResult for publish session
   _haSendResult = true;
 
-  // execute commands
+  // queue commands to the stove bus with publish flag to true
+  // results are published by appRun as they come, remaining commands are skipped after a failure
+  _publishCycle++;
+  if (!_publishCycle)
+    _publishCycle++; // 0 is reserved to commands not part of a cycle
+
   for (const __FlashStringHelper *cmd : cmdList)
   {
-    String strJson;
-    // execute command with publish flag to true
-    if (!executePalaCmd(cmd, strJson, true))
+    if (!submitPalaCmd(cmd, StoveLaneBackground, true, false, _publishCycle))
       break;
+    _publishCycleJobsPending++;
   }
 }
 
-void WPalaControl::udpRequestHandler(WiFiUDP &udpServer)
+// return true if requester got an answer too recently
+bool WPalaControl::udpRateLimit(const IPAddress &ip)
 {
+  UdpSource *source = nullptr;
+  UdpSource *oldest = &_udpSources[0];
+
+  for (UdpSource &udpSource : _udpSources)
+  {
+    if (udpSource.ip == ip)
+    {
+      source = &udpSource;
+      break;
+    }
+    if (udpSource.lastAnswerMillis < oldest->lastAnswerMillis)
+      oldest = &udpSource;
+  }
+
+  if (source && millis() - source->lastAnswerMillis < UDP_RATE_LIMIT_INTERVAL)
+  {
+    _udpRateLimited++;
+    return true;
+  }
+
+  // unknown requester replaces the least recent one
+  if (!source)
+  {
+    source = oldest;
+    source->ip = ip;
+  }
+  source->lastAnswerMillis = millis();
+  return false;
+}
 
-  int packetSize = udpServer.parsePacket();
-  if (packetSize <= 0)
+// answer from cache, stove is read (by the stove bus) only if answer is too old
+void WPalaControl::udpCachedAnswer(UdpCachedAnswer &answer, const __FlashStringHelper *cmd, const IPAddress &ip, uint16_t port)
+{
+  if (answer.payload.length() && millis() - answer.millis < UDP_CACHE_TTL)
+  {
+    _udpCacheHits++;
+    udpSend(ip, port, answer.payload);
     return;
+  }
 
-  String strData;
-  String strAnswer;
+  // requester waits for the stove read already queued (answers beyond waiters capacity are dropped, apps retry)
+  if (answer.waiterCount < UDP_CACHE_WAITERS)
+  {
+    answer.waiters[answer.waiterCount].ip = ip;
+    answer.waiters[answer.waiterCount].port = port;
+    answer.waiterCount++;
+  }
 
-  strData.reserve(packetSize + 1);
+  if (answer.pending)
+    return;
 
-  // while udpServer.read() do not return -1, get returned value and add it to strData
-  int bufferByte;
-  while ((bufferByte = udpServer.read()) >= 0)
-    strData += (char)bufferByte;
+  // result is sent by processStoveBusResults
+  PalaCmdJob *job = new PalaCmdJob;
+  job->cmd = cmd;
+  job->lane = StoveLaneUser;
+  job->submitMillis = millis();
+  job->udpAnswer = &answer;
 
-  // process request
-  if (strData.endsWith(F("bridge?")))
-    executePalaCmd(F("GET STDT"), strAnswer);
-  else if (strData.endsWith(F("bridge?GET ALLS")))
-    executePalaCmd(F("GET ALLS"), strAnswer);
-  else
-    executePalaCmd("", strAnswer);
+  if (submitPalaCmdJob(job))
+  {
+    answer.pending = true;
+    return;
+  }
+
+  delete job;
+
+  // queue is full (stove is not answering fast enough), answer with an error
+  String strError(palaCmdError(cmd, F("Stove bus busy")));
+  for (byte i = 0; i < answer.waiterCount; i++)
+    udpSend(answer.waiters[i].ip, answer.waiters[i].port, strError);
+  answer.waiterCount = 0;
+}
+
+void WPalaControl::udpCachedAnswerResult(UdpCachedAnswer &answer, const String &strJson, bool success)
+{
+  answer.pending = false;
+  answer.payload = strJson;
+  // failures are not cached (stove may be back on next request)
+  answer.millis = (success ? millis() : millis() - UDP_CACHE_TTL);
+
+  for (byte i = 0; i < answer.waiterCount; i++)
+    udpSend(answer.waiters[i].ip, answer.waiters[i].port, answer.payload);
+  answer.waiterCount = 0;
+}
+
+void WPalaControl::udpSend(const IPAddress &ip, uint16_t port, const String &payload)
+{
+  _udpServer.beginPacket(ip, port);
+  _udpServer.write((const uint8_t *)payload.c_str(), payload.length());
+  _udpServer.endPacket();
+}
+
+void WPalaControl::udpRequestHandler(WiFiUDP &udpServer)
+{
+  char request[UDP_BUFFER_SIZE];
 
-  // answer to the requester
-  udpServer.beginPacket(udpServer.remoteIP(), udpServer.remotePort());
-  udpServer.write((const uint8_t *)strAnswer.c_str(), strAnswer.length());
-  udpServer.endPacket();
+  // drain queued datagrams (apps broadcast discovery probes repeatedly)
+  for (byte packet = 0; packet < UDP_MAX_PACKETS_PER_RUN; packet++)
+  {
+    int packetSize = udpServer.parsePacket();
+    if (packetSize <= 0)
+      return;
+
+    int length = udpServer.read(request, sizeof(request) - 1);
+    if (length < 0)
+      length = 0;
+    request[length] = 0;
+
+    // ignore requesters asking too often
+    if (udpRateLimit(udpServer.remoteIP()))
+      continue;
+
+    // process request (answer is sent from cache or once the stove bus read it)
+    if (length >= 7 && !strcmp_P(request + length - 7, PSTR("bridge?")))
+      udpCachedAnswer(_udpStdtAnswer, F("GET STDT"), udpServer.remoteIP(), udpServer.remotePort());
+    else if (length >= 15 && !strcmp_P(request + length - 15, PSTR("bridge?GET ALLS")))
+      udpCachedAnswer(_udpAllsAnswer, F("GET ALLS"), udpServer.remoteIP(), udpServer.remotePort());
+    else
+      udpSend(udpServer.remoteIP(), udpServer.remotePort(), palaCmdError(F("UNKNOWN"), F("No valid request received")));
+  }
 }
 
 //------------------------------------------
@@ -2680,6 +4413,56 @@ String WPalaControl::generateStatusJSON()
   else
     doc[F("haprotocol")] = F("Disabled");
 
+  // Stove communication status
+  doc[F("stovebus")] = (_stoveOffline ? F("Offline") : F("Online"));
+
+  // Stove RX statistics
+  doc[F("stoverxframes")] = _stoveRxStats.frames;
+  if (_stoveRxStats.frames)
+  {
+    doc[F("stoverxlatencymin")] = _stoveRxStats.latencyMin / 1000.0;
+    doc[F("stoverxlatencyavg")] = (uint32_t)(_stoveRxStats.latencyTotal / _stoveRxStats.frames) / 1000.0;
+    doc[F("stoverxlatencymax")] = _stoveRxStats.latencyMax / 1000.0;
+  }
+  doc[F("stoverxoverruns")] = _stoveRxStats.overruns;
+  doc[F("stoverxerrors")] = _stoveRxStats.errors;
+
+  // Stove round trip time estimations (SRTT/RTTVAR/RTO in ms)
+  const char *cmdClassNames[StoveCmdClassCount] = {"read", "bulk", "write"};
+  for (byte i = 0; i < StoveCmdClassCount; i++)
+  {
+    if (!_stoveRtt[i].samples)
+      continue;
+
+    char rtt[48];
+    snprintf_P(rtt, sizeof(rtt), PSTR("%.1f/%.1f/%lu"), _stoveRtt[i].srtt / 1000.0, _stoveRtt[i].rttvar / 1000.0, stoveRto((StoveCmdClass)i));
+    doc[String(F("stovertt")) + cmdClassNames[i]] = rtt;
+  }
+  doc[F("stoveadaptiveretries")] = _stoveAdaptiveRetries;
+
+  doc[F("coalescedwrites")] = _coalescedWrites;
+  doc[F("stovebusrefused")] = _stoveBusAdmission.refused();
+
+  _history.fillStatusJSON(doc);
+
+  doc[F("udpcachehits")] = _udpCacheHits;
+  doc[F("udpratelimited")] = _udpRateLimited;
+
+  doc[F("evtsrcclients")] = _eventSourceMan.getClientCount();
+  doc[F("evtsrcevicted")] = _eventSourceMan.getEvictedClients();
+#if WS_ENABLED
+  doc[F("wsport")] = WS_PORT;
+  doc[F("wsclients")] = _webSocketMan.connectedClients();
+#endif
+
+  // Home Assistant controls latency (command received to answer published)
+  if (_cmdAckCount)
+  {
+    doc[F("cmdacklast")] = _cmdAckLast;
+    doc[F("cmdackavg")] = _cmdAckTotal / _cmdAckCount;
+    doc[F("cmdackmax")] = _cmdAckMax;
+  }
+
   // Home automation connection status
   if (_ha.protocol == HA_PROTO_MQTT)
   {
@@ -2704,6 +4487,7 @@ bool WPalaControl::appInit(bool reInit)
 
   // Stop Publish
   _publishTicker.detach();
+  _statusWatchTicker.detach();
 
   // Stop MQTT
   _mqttMan.disconnect();
@@ -2728,53 +4512,50 @@ bool WPalaControl::appInit(bool reInit)
     _mqttMan.connect(_ha.mqtt.username, _ha.mqtt.password);
   }
 
-  LOG_SERIAL_PRINT(F("Connecting to Stove..."));
-
-// Initialize hw version detection
-#ifdef ESP8266
-  uint8_t hwDetectPin = 5;
-#else
-  uint8_t hwDetectPin = 22;
+#ifndef ESP8266
+  // Start stove bus task on the core not running loop() (only once)
+  if (!_stoveBusTask)
+  {
+    _stoveBusMutex = xSemaphoreCreateRecursiveMutex();
+    _stoveRxSemaphore = xSemaphoreCreateBinary();
+    xTaskCreatePinnedToCore(stoveBusTask, "stoveBus", STOVE_BUS_TASK_STACK, this, 1, &_stoveBusTask, STOVE_BUS_TASK_CORE);
+  }
 #endif
-  pinMode(hwDetectPin, INPUT_PULLUP);
-  delay(1);
-
-  if (digitalRead(hwDetectPin) == HIGH)
-    LOG_SERIAL_PRINT(F("HW1..."));
-  else
-    LOG_SERIAL_PRINT(F("HW2..."));
 
-  Palazzetti::CommandResult cmdRes;
-  cmdRes = _Pala.initialize(
-      std::bind(&WPalaControl::myOpenSerial, this, std::placeholders::_1),
-      std::bind(&WPalaControl::myCloseSerial, this),
-      std::bind(&WPalaControl::mySelectSerial, this, std::placeholders::_1),
-      std::bind(&WPalaControl::myReadSerial, this, std::placeholders::_1, std::placeholders::_2),
-      std::bind(&WPalaControl::myWriteSerial, this, std::placeholders::_1, std::placeholders::_2),
-      std::bind(&WPalaControl::myDrainSerial, this),
-      std::bind(&WPalaControl::myFlushSerial, this),
-      std::bind(&WPalaControl::myUSleep, this, std::placeholders::_1),
-      digitalRead(hwDetectPin) == HIGH);
+  // reload stored history (only once)
+  if (!reInit)
+    _history.begin();
 
-  if (cmdRes == Palazzetti::CommandResult::OK)
-  {
-    LOG_SERIAL_PRINTLN(F("Stove connected"));
-    char SN[28];
-    _Pala.getSN(&SN);
-    LOG_SERIAL_PRINTF_P(PSTR("Stove Serial Number: %s\n"), SN);
-  }
-  else
-    LOG_SERIAL_PRINTLN(F("Stove connection failed"));
+  // Reset stove circuit breaker
+  _stoveProbeTicker.detach();
+  _needStoveProbe = false;
+  _stoveOffline = false;
+  _stoveFailures = 0;
 
-  if (cmdRes == Palazzetti::CommandResult::OK)
-    publishTick(); // if configuration changed, publish immediately
+  // Start stove attach in background (hw version detection then stove initialization)
+  // stove data are published as soon as it is attached
+  pinMode(HW_DETECT_PIN, INPUT_PULLUP);
+  _stoveAttachMillis = millis();
+  _stoveAttachState = StoveDetectHW;
 
 #ifdef ESP8266
   _publishTicker.attach(_ha.uploadPeriod, [this]()
-                        { this->_needPublish = true; });
+                        { TRACE_INSTANT("publishTicker");
+                          this->_needPublish = true; });
 #else
   _publishTicker.attach<typeof this>(_ha.uploadPeriod, [](typeof this palaControl)
-                                     { palaControl->_needPublish = true; }, this);
+                                     { TRACE_INSTANT("publishTicker");
+                                       palaControl->_needPublish = true; }, this);
+#endif
+
+  // fast status watcher
+  _statusKnown = false;
+#ifdef ESP8266
+  _statusWatchTicker.attach(STOVE_WATCH_INTERVAL, [this]()
+                            { this->_needStatusWatch = true; });
+#else
+  _statusWatchTicker.attach<typeof this>(STOVE_WATCH_INTERVAL, [](typeof this palaControl)
+                                         { palaControl->_needStatusWatch = true; }, this);
 #endif
 
   // flag to force publish update (init and reinit)
@@ -2792,7 +4573,7 @@ bool WPalaControl::appInit(bool reInit)
   // Start UDP Server
   _udpServer.begin(54549);
 
-  return cmdRes == Palazzetti::CommandResult::OK;
+  return true;
 }
 
 //------------------------------------------
@@ -2839,168 +4620,84 @@ void WPalaControl::appInitWebServer(WebServer &server)
   // Handle HTTP GET requests
   server.on(F("/cgi-bin/sendmsg.lua"), HTTP_GET, [this, &server]()
             {
+    HEAP_SCOPE(HeapHttp);
+    TRACE_SCOPE("httpSendMsgGet");
+
     String cmd;
-    String strJson;
 
     if (server.hasArg(F("cmd"))) cmd = server.arg(F("cmd"));
 
     // WPalaControl specific command
-    if (cmd.startsWith(F("BKP PARM ")))
+    if (cmd.startsWith(F("BKP PARM ")) || cmd.startsWith(F("BKP HPAR ")))
     {
-      byte fileType;
-
-      String strFileType(cmd.substring(9));
-
-      if (strFileType == F("CSV"))
-        fileType = 0;
-      else if (strFileType == F("JSON"))
-        fileType = 1;
-      else
-      {
-        String ret(F("{\"INFO\":{\"CMD\":\"BKP PARM\",\"MSG\":\"Incorrect File Type : "));
-        ret += strFileType;
-        ret += F("\"},\"SUCCESS\":false,\"DATA\":{\"NODATA\":true}}");
-        SERVER_KEEPALIVE_FALSE()
-        server.send(200, F("text/json"), ret);
-        return;
-      }
-
-      byte params[0x6A];
-      Palazzetti::CommandResult cmdRes = _Pala.getAllParameters(&params);
-
-      if (cmdRes == Palazzetti::CommandResult::OK)
-      {
-        String toReturn;
-
-        switch (fileType)
-        {
-        case 0: //CSV
-          toReturn += F("PARM;VALUE\r\n");
-          for (byte i = 0; i < 0x6A; i++)
-            toReturn += String(i) + ';' + params[i] + '\r' + '\n';
-
-          SERVER_KEEPALIVE_FALSE()
-          server.sendHeader(F("Content-Disposition"), F("attachment; filename=\"PARM.csv\""));
-          server.send(200, F("text/csv"), toReturn);
-          break;
-
-        case 1: //JSON
-          JsonDocument doc;
-          JsonArray PARM = doc[F("PARM")].to<JsonArray>();
-          for (byte i = 0; i < 0x6A; i++)
-            PARM.add(params[i]);
-
-          serializeJson(doc, toReturn);
-
-          SERVER_KEEPALIVE_FALSE()
-          server.sendHeader(F("Content-Disposition"), F("attachment; filename=\"PARM.json\""));
-          server.send(200, F("text/json"), toReturn);
-          break;
-        }
-
-        return;
-      }
-      else
-      {
-        SERVER_KEEPALIVE_FALSE()
-        server.send(200, F("text/json"), F("{\"INFO\":{\"CMD\":\"BKP PARM\",\"MSG\":\"Stove communication failed\",\"RSP\":\"TIMEOUT\"},\"SUCCESS\":false,\"DATA\":{\"NODATA\":true}}"));
-        return;
-      }
+      backupPalaParams(cmd, server);
+      return;
     }
 
     // WPalaControl specific command
-    if (cmd.startsWith(F("BKP HPAR ")))
+    if (cmd.startsWith(F("BKP ADRR ")))
     {
-      byte fileType;
-
-      String strFileType(cmd.substring(9));
-
-      if (strFileType == F("CSV"))
-        fileType = 0;
-      else if (strFileType == F("JSON"))
-        fileType = 1;
-      else
-      {
-        String ret(F("{\"INFO\":{\"CMD\":\"BKP HPAR\",\"MSG\":\"Incorrect File Type : "));
-        ret += strFileType;
-        ret += F("\"},\"SUCCESS\":false,\"DATA\":{\"NODATA\":true}}");
-        SERVER_KEEPALIVE_FALSE()
-        server.send(200, F("text/json"), ret);
-        return;
-      }
-
-      uint16_t hiddenParams[0x6F];
-      Palazzetti::CommandResult cmdRes = _Pala.getAllHiddenParameters(&hiddenParams);
-
-      if (cmdRes == Palazzetti::CommandResult::OK)
-      {
-        String toReturn;
-
-        switch (fileType)
-        {
-        case 0: //CSV
-          toReturn += F("HPAR;VALUE\r\n");
-          for (byte i = 0; i < 0x6F; i++)
-            toReturn += String(i) + ';' + hiddenParams[i] + '\r' + '\n';
-
-          SERVER_KEEPALIVE_FALSE()
-          server.sendHeader(F("Content-Disposition"), F("attachment; filename=\"HPAR.csv\""));
-          server.send(200, F("text/csv"), toReturn);
-          break;
-
-        case 1: //JSON
-          JsonDocument doc;
-          JsonArray HPAR = doc[F("HPAR")].to<JsonArray>();
-          for (byte i = 0; i < 0x6F; i++)
-            HPAR.add(hiddenParams[i]);
-
-          serializeJson(doc, toReturn);
-
-          SERVER_KEEPALIVE_FALSE()
-          server.sendHeader(F("Content-Disposition"), F("attachment; filename=\"HPAR.json\""));
-          server.send(200, F("text/json"), toReturn);
-          break;
-        }
-
-        return;
-      }
-      else
-      {
-        SERVER_KEEPALIVE_FALSE()
-        server.send(200, F("text/json"), F("{\"INFO\":{\"CMD\":\"BKP HPAR\",\"MSG\":\"Stove communication failed\",\"RSP\":\"TIMEOUT\"},\"SUCCESS\":false,\"DATA\":{\"NODATA\":true}}"));
-        return;
-      }
+      dumpPalaMemory(cmd, server);
+      return;
     }
 
-    // Other commands processed using normal Palazzetti logic
-    executePalaCmd(cmd, strJson);
-
-    // send response
-    SERVER_KEEPALIVE_FALSE()
-    server.send(200, F("text/json"), strJson); });
+    // Other commands processed using normal Palazzetti logic (answered once the stove bus processed it)
+    submitHttpPalaCmd(cmd, server); });
 
   // Handle HTTP POST requests (Body contains a JSON)
   server.on(
       F("/cgi-bin/sendmsg.lua"), HTTP_POST, [this, &server]()
       {
+        HEAP_SCOPE(HeapHttp);
+        TRACE_SCOPE("httpSendMsgPost");
+
         String cmd;
         JsonDocument jsonDoc;
-        String strJson;
+
+        // WPalaControl specific command (cmd in URL, backup file in body)
+        if (server.hasArg(F("cmd")) && (cmd = server.arg(F("cmd"))).startsWith(F("RST ")))
+        {
+          restorePalaParams(cmd, server.arg(F("plain")), server);
+          return;
+        }
+        cmd = "";
 
         DeserializationError error = deserializeJson(jsonDoc, server.arg(F("plain")));
 
         if (!error && !jsonDoc[F("command")].isNull())
           cmd = jsonDoc[F("command")].as<String>();
 
-        // process cmd
-        executePalaCmd(cmd, strJson);
+        // process cmd (answered once the stove bus processed it)
+        submitHttpPalaCmd(cmd, server); });
+
+  // Handle Prometheus/OpenMetrics scrapes (served from cached values only)
+  server.on(F("/metrics"), HTTP_GET, [this, &server]()
+            {
+    TRACE_SCOPE("httpMetrics");
+    SERVER_KEEPALIVE_FALSE()
+    streamMetrics(server); });
+
+  // Handle history requests (from: unix time, fields: comma separated list, format: json or bin)
+  server.on(F("/history"), HTTP_GET, [this, &server]()
+            {
+    TRACE_SCOPE("httpHistory");
+
+    uint32_t from = 0;
+    if (server.hasArg(F("from"))) from = server.arg(F("from")).toInt();
 
-        // send response
-        SERVER_KEEPALIVE_FALSE()
-        server.send(200, F("text/json"), strJson); });
+    uint16_t fieldMask = StoveHistory::parseFields(server.arg(F("fields")));
+    bool binary = server.arg(F("format")) == F("bin");
+
+    SERVER_KEEPALIVE_FALSE()
+    _history.streamHistory(server, from, fieldMask, binary); });
 
   // register EventSource
   _eventSourceMan.initEventSourceServer(getAppIdChar(_appId), server);
+
+#if WS_ENABLED
+  // start WebSocket server (status updates and commands over one connection)
+  _webSocketMan.begin(std::bind(&WPalaControl::webSocketCommand, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3));
+#endif
 }
 
 //------------------------------------------
@@ -3009,27 +4706,83 @@ void WPalaControl::appRun()
 {
   if (_ha.protocol == HA_PROTO_MQTT)
   {
-    _mqttMan.loop();
+    {
+      PERF_SCOPE(StageMqtt);
+      _mqttMan.loop();
+    }
 
     // if Home Assistant discovery enabled and publish is needed (and publish is successful)
-    if (_ha.mqtt.hassDiscoveryEnabled && _needPublishHassDiscovery && mqttPublishHassDiscovery())
+    // stove data are read on the stove bus first (background lane, after user commands)
+    if (_ha.mqtt.hassDiscoveryEnabled && _needPublishHassDiscovery)
+    {
+      PERF_SCOPE(StageDiscovery);
+      if (mqttPublishHassDiscovery())
+      {
+        _needPublishHassDiscovery = false;
+        _needPublish = true; // force publishTick after discovery
+      }
+    }
+
+    if (_needPublishUpdate)
     {
-      _needPublishHassDiscovery = false;
-      _needPublish = true; // force publishTick after discovery
+      PERF_SCOPE(StageUpdate);
+      if (mqttPublishUpdate())
+        _needPublishUpdate = false;
     }
+  }
 
-    if (_needPublishUpdate && mqttPublishUpdate())
-      _needPublishUpdate = false;
+  {
+    PERF_SCOPE(StageStoveAttach);
+
+    stoveAttachRun();
+
+    if (_needStoveProbe)
+    {
+      _needStoveProbe = false;
+      stoveProbe();
+    }
   }
 
   if (_needPublish)
   {
+    PERF_SCOPE(StagePublish);
     _needPublish = false;
     publishTick();
   }
 
+  if (_needStatusWatch)
+  {
+    _needStatusWatch = false;
+    statusWatchRun();
+  }
+
+  // execute queued stove commands (ESP8266) and publish their results
+  {
+    PERF_SCOPE(StageStove);
+    flushCoalescedWrites();
+    stoveBusRun();
+  }
+  {
+    PERF_SCOPE(StageBusResults);
+    processStoveBusResults();
+  }
+
   // Handle UDP requests
-  udpRequestHandler(_udpServer);
+  {
+    PERF_SCOPE(StageUdp);
+    udpRequestHandler(_udpServer);
+  }
+
+  // send pending events and remove dead clients
+  _eventSourceMan.run();
+
+#if WS_ENABLED
+  // Handle WebSocket clients
+  {
+    PERF_SCOPE(StageWebSocket);
+    _webSocketMan.run();
+  }
+#endif
 }
 
 //------------------------------------------
@@ -4,7 +4,9 @@
 #include "Main.h"
 #include "base/MQTTMan.h"
 #include "base/EventSourceMan.h"
+#include "base/WebSocketMan.h"
 #include "base/Application.h"
+#include "base/PerfMonitor.h"
 
 const char appDataPredefPassword[] PROGMEM = "ewcXoCt4HHjZUvY1";
 
@@ -13,10 +15,56 @@ const char appDataPredefPassword[] PROGMEM = "ewcXoCt4HHjZUvY1";
 
 #include <Palazzetti.h>
 #include <WiFiUdp.h>
+#include <atomic>
+#include <memory>
+
+#include "SpscQueue.h"
+#include "StoveBusAdmission.h"
+#include "WsSessions.h"
+#include "AdrrDump.h"
+#include "StoveHistory.h"
 
 class WPalaControl : public Application
 {
 private:
+#define ADRR_MAX_JSON_LENGTH 64    // max number of addresses returned by EXT ADRR
+#define ADRR_MAX_DUMP_LENGTH 0x100  // max number of addresses dumped by BKP ADRR (dump is kept in RAM until sent, bigger areas need several requests)
+#define ADRR_READ_INTERVAL 10       // min time between two memory reads (in ms) to not starve the stove panel
+
+#define STOVE_BREAKER_THRESHOLD 3   // consecutive communication failures before considering the stove offline
+#define STOVE_BREAKER_MIN_BACKOFF 5 // delay before the first stove probe (in seconds)
+#define STOVE_BREAKER_MAX_BACKOFF 300
+
+#define STOVE_RX_BUFFER_SIZE 256     // UART RX ring buffer size (bigger than any stove frame)
+#define STOVE_RX_TIMEOUT_SYMBOLS 3   // ESP32 only : silence (in characters time) marking the end of a frame
+
+#define STOVE_RTO_ENABLED 1        // adapt stove answer timeout to observed round trip time
+#define STOVE_RTO_MIN 20           // min answer timeout (in ms) whatever the observed round trip time
+#define STOVE_RTO_MIN_SAMPLES 8    // samples needed before using adaptive timeout
+
+// interval between two stove status reads to detect alarms quickly (in seconds)
+// (ESP8266 executes stove commands in loop, so each read blocks it for a bus transaction)
+#ifdef ESP8266
+#define STOVE_WATCH_INTERVAL 10
+#else
+#define STOVE_WATCH_INTERVAL 1
+#endif
+
+#define PALA_COALESCE_WINDOW_MS 300 // writes to the same register received within this window are merged (slider controls)
+#define PALA_COALESCE_WS_WAITERS 4  // WebSocket requesters answered by one merged write (window ends early when full)
+
+#define STOVE_BUS_QUEUE_SIZE 16      // max number of stove commands queued for the stove bus (+1)
+#define STOVE_BUS_BACKGROUND_SLOTS 10 // of which background polling can use (whole publish cycle + discovery read + spare)
+#define STOVE_BUS_TASK_STACK 8192    // ESP32 only : stove bus task stack size
+#define STOVE_BUS_TASK_CORE 0        // ESP32 only : core running the stove bus task (loop() runs on the other one)
+
+#define UDP_BUFFER_SIZE 64           // bridge requests are short ("bridge?GET ALLS"), longer ones are truncated
+#define UDP_MAX_PACKETS_PER_RUN 4    // datagrams handled per appRun
+#define UDP_CACHE_TTL 5000           // bridge? and bridge?GET ALLS answers are reused during this time (in ms)
+#define UDP_CACHE_WAITERS 4          // requesters waiting for the same stove read (others are ignored and retry)
+#define UDP_RATE_LIMIT_SOURCES 4     // number of requesters tracked for rate limiting
+#define UDP_RATE_LIMIT_INTERVAL 500  // min time between two answers to the same requester (in ms)
+
 #define HA_MQTT_GENERIC 0
 #define HA_MQTT_GENERIC_JSON 1
 #define HA_MQTT_GENERIC_CATEGORIZED 2
@@ -51,18 +99,279 @@ private:
   WiFiClient _wifiClient;
   MQTTMan _mqttMan;
   EventSourceMan _eventSourceMan;
+#if WS_ENABLED
+  WebSocketMan _webSocketMan;
+#endif
   WiFiUDP _udpServer;
 
   Palazzetti _Pala;
   unsigned long _lastAllStatusRefreshMillis = 0;
 
+  typedef enum
+  {
+    StoveDetectHW,   // hardware version detection pin is settling
+    StoveInit,       // stove communication needs to be initialized
+    StoveInitQueued, // initialization is running on the stove bus
+    StoveAttached    // stove communication initialized
+  } StoveAttachState;
+
+  StoveAttachState _stoveAttachState = StoveDetectHW;
+  unsigned long _stoveAttachMillis = 0;
+  bool _stoveHWV1 = true;
+
+  uint8_t _stoveFailures = 0;  // consecutive stove communication failures
+  bool _stoveOffline = false;  // circuit breaker open : stove requests fail immediately
+  bool _stoveProbing = false;  // probe in progress : stove bus is usable even if offline
+  bool _needStoveProbe = false;
+  uint16_t _stoveProbeBackoff = STOVE_BREAKER_MIN_BACKOFF;
+  Ticker _stoveProbeTicker;
+
+  // result of the stove bus half of a command (before publish/serialization)
+  typedef struct
+  {
+    JsonDocument jsonDoc;
+    String palaCategory; // used to return data to the correct MQTT category (if needed)
+    bool cmdProcessed = false;
+    Palazzetti::CommandResult cmdSuccess = Palazzetti::CommandResult::COMMUNICATION_ERROR;
+  } PalaCmdResult;
+
+  // stove bus priority lanes (highest first)
+  typedef enum
+  {
+    StoveLaneInteractive, // SET/CMD from user (Home Assistant controls)
+    StoveLaneUser,        // explicit GET from user
+    StoveLaneBackground,  // periodic polling
+    StoveLaneCount
+  } StoveLane;
+
+  // what a job does on the stove bus
+  typedef enum
+  {
+    StoveJobCommand,   // Palazzetti command (cmd)
+    StoveJobAttach,    // initialize stove communication
+    StoveJobProbe,     // circuit breaker probe
+    StoveJobDiscovery, // read stove data needed by Home Assistant discovery
+    StoveJobBackup,    // BKP PARM/HPAR : read all parameters
+    StoveJobRestore,   // RST PARM/HPAR : write back parameters which differ from the backup
+    StoveJobDump       // BKP ADRR : memory dump resumed between other commands
+  } StoveJobType;
+
+  // stove data needed by Home Assistant discovery
+  typedef struct
+  {
+    char SN[28];
+    uint16_t MOD, VER;
+    char FWDATE[11];
+    uint16_t SPLMIN, SPLMAX;
+    byte UICONFIG;
+    byte MAINTPROBE;
+    byte STOVETYPE;
+    byte FAN2TYPE;
+    byte FAN2MODE;
+    float SETP;
+    uint16_t FANLMINMAX[6];
+  } HassDiscoveryData;
+
+  typedef struct
+  {
+    IPAddress ip;
+    uint16_t port = 0;
+  } UdpRequester;
+
+  // pre-serialized UDP bridge answers
+  typedef struct
+  {
+    String payload;
+    unsigned long millis = 0;
+    bool pending = false; // stove read queued on the stove bus
+    UdpRequester waiters[UDP_CACHE_WAITERS];
+    uint8_t waiterCount = 0;
+  } UdpCachedAnswer;
+
+  // WebSocket requester waiting for a command result
+  typedef struct
+  {
+    WsSession session; // connection which sent the command
+    String id;         // correlation id given by the WebSocket client
+  } WsWaiter;
+
+  // command exchanged between loop() and the stove bus
+  typedef struct
+  {
+    StoveJobType type = StoveJobCommand;
+    String cmd;
+    bool publish = false;
+    bool publishResult = false; // answer is published on MQTT result topic
+    StoveLane lane = StoveLaneBackground;
+    uint32_t cycle = 0;   // publish cycle of the command (0 if not part of a cycle)
+    bool skipped = false; // not executed because a previous command of the same cycle failed
+    unsigned long submitMillis = 0;
+    uint8_t coalesced = 1; // number of requests merged in this one
+    bool statusWatch = false;
+    WsWaiter wsWaiters[PALA_COALESCE_WS_WAITERS]; // WebSocket clients to answer (several ones when writes are merged)
+    uint8_t wsWaiterCount = 0;
+    bool httpAnswer = false;                  // answer is sent to httpClient
+    bool backupCsv = false;                   // BKP PARM/HPAR file type
+    WiFiClient httpClient;                    // HTTP client waiting for the answer (kept like EventSource clients)
+    UdpCachedAnswer *udpAnswer = nullptr;     // UDP bridge answer refreshed by this command
+    std::unique_ptr<int32_t[]> restoreValues; // RST PARM/HPAR : wanted values (-1 if not in backup)
+    std::unique_ptr<HassDiscoveryData> discovery;
+    std::unique_ptr<AdrrDump> dump;
+    PalaCmdResult result;
+  } PalaCmdJob;
+
+  // write waiting for its coalescing window to end
+  typedef enum
+  {
+    CoalesceSetpoint, // SETP and STPF
+    CoalescePower,
+    CoalesceRoomFan,
+    CoalesceFan3,
+    CoalesceFan4,
+    CoalesceGroupCount
+  } CoalesceGroup;
+
+  typedef struct
+  {
+    String cmd; // last received command (empty if none pending)
+    unsigned long firstMillis = 0;
+    uint8_t count = 0;
+    bool publishResult = false; // one of the merged writes came from MQTT
+    WsWaiter wsWaiters[PALA_COALESCE_WS_WAITERS];
+    uint8_t wsWaiterCount = 0;
+  } PendingWrite;
+
+  PendingWrite _pendingWrites[CoalesceGroupCount];
+  uint32_t _coalescedWrites = 0; // bus writes saved by coalescing
+
+  SpscQueue<PalaCmdJob *, STOVE_BUS_QUEUE_SIZE> _stoveBusRequests[StoveLaneCount]; // pushed by loop(), popped by stove bus
+  SpscQueue<PalaCmdJob *, STOVE_BUS_QUEUE_SIZE> _stoveBusResults;                  // pushed by stove bus, popped by loop()
+  StoveBusAdmission _stoveBusAdmission{STOVE_BUS_QUEUE_SIZE - 1, STOVE_BUS_BACKGROUND_SLOTS};
+  PalaCmdJob *_stoveBusResumedJob = nullptr; // stove bus only : memory dump waiting for its next read
+
+  // interactive commands latency (from MQTT reception to answer publish) in ms
+  uint32_t _cmdAckCount = 0;
+  uint32_t _cmdAckLast = 0;
+  uint32_t _cmdAckMax = 0;
+  uint32_t _cmdAckTotal = 0;
+  uint32_t _publishCycle = 0;
+  uint8_t _publishCycleJobsPending = 0; // commands of the current publish cycle not yet processed
+  uint32_t _stoveBusFailedCycle = 0;
+#ifndef ESP8266
+  TaskHandle_t _stoveBusTask = nullptr;
+  SemaphoreHandle_t _stoveBusMutex = nullptr;   // protects _Pala from concurrent use by loop() and stove bus task
+  SemaphoreHandle_t _stoveRxSemaphore = nullptr; // given by UART driver when data are received
+
+  static void stoveBusTask(void *pvParameters);
+#endif
+
+  // Keep exclusive use of the stove bus during its scope
+  class StoveBusLock
+  {
+  private:
+    WPalaControl *_palaControl;
+
+  public:
+    StoveBusLock(WPalaControl *palaControl) : _palaControl(palaControl)
+    {
+#ifndef ESP8266
+      xSemaphoreTakeRecursive(_palaControl->_stoveBusMutex, portMAX_DELAY);
+#endif
+    };
+    ~StoveBusLock()
+    {
+#ifndef ESP8266
+      xSemaphoreGiveRecursive(_palaControl->_stoveBusMutex);
+#endif
+    };
+  };
+
+  // fast status watcher (STATUS/LSTATUS/FSTATUS transitions)
+  bool _needStatusWatch = false;
+  bool _statusWatchPending = false;
+  bool _statusKnown = false;
+  uint16_t _lastStatus[3] = {0}; // STATUS, LSTATUS, FSTATUS
+  Ticker _statusWatchTicker;
+
+  void statusWatchRun();
+  void statusWatchResult(const JsonDocument &jsonDoc);
+
   bool _needPublish = false;
   Ticker _publishTicker;
   bool _publishedStoveConnected = false;
   bool _needPublishHassDiscovery = false;
+  bool _hassDiscoveryReadPending = false;
+  std::unique_ptr<HassDiscoveryData> _hassDiscoveryData; // read before publishing stove entities
   bool _needPublishUpdate = false;
   Ticker _publishUpdateTicker;
 
+  // stove RX statistics (updated by UART driver callbacks on ESP32)
+  typedef struct
+  {
+    volatile uint32_t frames = 0;   // answers received
+    volatile uint32_t overruns = 0; // bytes lost because RX buffer was full
+    volatile uint32_t errors = 0;   // framing/parity/break errors
+    volatile uint32_t latencyMin = 0;
+    volatile uint32_t latencyMax = 0;
+    volatile uint64_t latencyTotal = 0; // time between end of request and answer frame (in us)
+  } StoveRxStats;
+
+  StoveRxStats _stoveRxStats;
+  volatile bool _stoveRxFrameExpected = false;
+  volatile unsigned long _stoveTxEndMicros = 0;
+
+  void stoveRxFrameReceived();
+
+  typedef enum
+  {
+    StoveCmdRead,     // single value read
+    StoveCmdBulkRead, // big frames (all status, static data, parameters)
+    StoveCmdWrite,    // SET/CMD (stove needs to apply the change before answering)
+    StoveCmdClassCount
+  } StoveCmdClass;
+
+  // stove round trip time estimation (like TCP RTO, RFC 6298) in us
+  typedef struct
+  {
+    uint32_t srtt = 0;
+    uint32_t rttvar = 0;
+    uint32_t samples = 0;
+  } StoveRttEstimate;
+
+  StoveRttEstimate _stoveRtt[StoveCmdClassCount];
+  StoveCmdClass _stoveCmdClass = StoveCmdRead;
+  bool _stoveCmdRunning = false;       // a command of _stoveCmdClass is running (RTT samples are valid)
+  bool _stoveAwaitingAnswer = false;    // next select is the first wait after a request
+  bool _stoveAdaptiveTimeout = false;   // adaptive timeout allowed for current command
+  bool _stoveShortTimeoutHit = false;   // an answer was missed with a timeout shorter than library one
+  uint32_t _stoveAdaptiveRetries = 0;
+
+  // Account round trip times of direct library calls in the right class (library timeout is kept)
+  class StoveCmdScope
+  {
+  private:
+    WPalaControl *_palaControl;
+
+  public:
+    StoveCmdScope(WPalaControl *palaControl, StoveCmdClass cmdClass) : _palaControl(palaControl)
+    {
+      setClass(cmdClass);
+      _palaControl->_stoveCmdRunning = true;
+    };
+    ~StoveCmdScope()
+    {
+      _palaControl->_stoveCmdRunning = false;
+    };
+    void setClass(StoveCmdClass cmdClass)
+    {
+      _palaControl->_stoveCmdClass = cmdClass;
+      _palaControl->_stoveAdaptiveTimeout = false;
+    };
+  };
+
+  unsigned long stoveRto(StoveCmdClass cmdClass);
+  void stoveRttSample(StoveCmdClass cmdClass, uint32_t rtt);
+
   int myOpenSerial(uint32_t baudrate);
   void myCloseSerial();
   int mySelectSerial(unsigned long timeout);
@@ -71,15 +380,81 @@ private:
   int myDrainSerial();
   int myFlushSerial();
   void myUSleep(unsigned long usecond);
+  bool isStoveBusBlocked() { return _stoveOffline && !_stoveProbing; };
+
+  Palazzetti::CommandResult initStove();
+  void stoveAttachRun();
+  void stoveAttachResult(Palazzetti::CommandResult cmdRes);
+  void stoveBusResult(bool success);
+  void scheduleStoveProbe();
+  void stoveProbe();
+  Palazzetti::CommandResult stoveBusProbe();
+  void stoveProbeResult(Palazzetti::CommandResult cmdRes);
 
   void mqttConnectedCallback(MQTTMan *mqttMan, bool firstConnection);
   void mqttDisconnectedCallback();
   void mqttCallback(char *topic, uint8_t *payload, unsigned int length);
   void mqttPublishStoveConnected(bool stoveConnected);
+#if WS_ENABLED
+  void webSocketCommand(uint8_t clientNum, const char *payload, size_t length);
+  void webSocketAnswer(const WsWaiter &wsWaiter, const String &strJson);
+#endif
   bool mqttPublishData(const String &baseTopic, const String &palaCategory, const JsonDocument &jsonDoc);
   bool mqttPublishHassDiscovery();
+  void hassDiscoveryRead();
+  void stoveBusDiscovery(PalaCmdJob *job);
   bool mqttPublishUpdate();
-  bool executePalaCmd(const String &cmd, String &strJson, bool publish = false);
+  void runPalaCmdOnBus(const String &cmd, PalaCmdResult &result);
+  void executePalaCmdOnBus(const String &cmd, PalaCmdResult &result);
+  bool processPalaCmdResult(const String &cmd, PalaCmdResult &result, String &strJson, bool publish);
+  bool submitPalaCmd(const String &cmd, StoveLane lane, bool publish, bool publishResult = false, uint32_t cycle = 0);
+  static bool isStoveBusBackgroundJob(const PalaCmdJob *job);
+  bool submitPalaCmdJob(PalaCmdJob *job);
+  bool coalescePalaWrite(const String &cmd, const WsWaiter *wsWaiter = nullptr);
+  bool flushCoalescedWrite(PendingWrite &pendingWrite);
+  void flushCoalescedWrites();
+  bool popNextStoveJob(PalaCmdJob *&job);
+  bool stoveBusProcessJob(PalaCmdJob *job);
+  bool stoveBusDumpStep(AdrrDump &dump);
+  void stoveBusRun();
+  void processStoveBusResults();
+  void submitHttpPalaCmd(const String &cmd, WebServer &server);
+  void backupPalaParams(const String &cmd, WebServer &server);
+  void stoveBusBackup(PalaCmdJob *job);
+  void sendPalaParamsBackup(PalaCmdJob *job);
+  void restorePalaParams(const String &cmd, const String &backup, WebServer &server);
+  void stoveBusRestore(PalaCmdJob *job);
+  void adrrReadPause(unsigned long &lastReadMillis);
+  void dumpPalaMemory(const String &cmd, WebServer &server);
+  void sendPalaMemoryDump(PalaCmdJob *job);
+  void sendDeferredResponse(WiFiClient &client, const __FlashStringHelper *contentType, const char *content, size_t length, const String &fileName = String());
+
+  StoveHistory _history;
+
+  // last values received from the stove for metrics (never read from the stove bus on scrape)
+  JsonDocument _stoveCache;
+  unsigned long _stoveCacheMillis = 0;
+
+  void updateStoveCache(JsonObjectConst data);
+  void streamMetrics(WebServer &server);
+
+  UdpCachedAnswer _udpStdtAnswer;
+  UdpCachedAnswer _udpAllsAnswer;
+
+  typedef struct
+  {
+    IPAddress ip;
+    unsigned long lastAnswerMillis = 0;
+  } UdpSource;
+
+  UdpSource _udpSources[UDP_RATE_LIMIT_SOURCES];
+  uint32_t _udpRateLimited = 0;
+  uint32_t _udpCacheHits = 0;
+
+  bool udpRateLimit(const IPAddress &ip);
+  void udpCachedAnswer(UdpCachedAnswer &answer, const __FlashStringHelper *cmd, const IPAddress &ip, uint16_t port);
+  void udpCachedAnswerResult(UdpCachedAnswer &answer, const String &strJson, bool success);
+  void udpSend(const IPAddress &ip, uint16_t port, const String &payload);
 
   void publishTick();
   void udpRequestHandler(WiFiUDP &udpServer);
@@ -87,6 +462,10 @@ private:
   void setConfigDefaultValues();
   bool parseConfigJSON(JsonDocument &doc, bool fromWebPage);
   String generateConfigJSON(bool forSaveFile);
+  uint16_t getConfigRecordVersion() { return 1; }; // to increase when HomeAutomation layout changes (JSON config is used meanwhile)
+  size_t getConfigRecordSize() { return sizeof(HomeAutomation); };
+  void writeConfigRecord(void *record) { memcpy(record, &_ha, sizeof(HomeAutomation)); };
+  void readConfigRecord(const void *record) { memcpy(&_ha, record, sizeof(HomeAutomation)); };
   String generateStatusJSON();
   bool appInit(bool reInit);
   const PROGMEM char *getHTMLContent(WebPageForPlaceHolder wp);
@@ -0,0 +1,36 @@
+#ifndef WsSessions_h
+#define WsSessions_h
+
+#include <stdint.h>
+
+// Identification of WebSocket connections (one per client slot, N slots)
+// A slot is reused by the next connection, so an answer computed for a previous connection must be dropped :
+// requesters keep the WsSession they got when their command was received and answers are sent only if it is still current
+// No Arduino dependency so it can be unit tested on host (pio test -e native)
+
+typedef struct
+{
+  uint8_t clientNum;
+  uint32_t generation; // connection using the client slot when the session was taken
+} WsSession;
+
+template <uint8_t N>
+class WsSessions
+{
+private:
+  uint32_t _generations[N] = {0}; // changed at each (dis)connection of a client slot
+
+public:
+  // a new connection (or none) now uses this client slot
+  void changed(uint8_t clientNum)
+  {
+    if (clientNum < N)
+      _generations[clientNum]++;
+  };
+
+  WsSession session(uint8_t clientNum) const { return {clientNum, clientNum < N ? _generations[clientNum] : 0}; };
+
+  bool isCurrent(const WsSession &session) const { return session.clientNum < N && _generations[session.clientNum] == session.generation; };
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include "Application.h"
 
 Application *Application::_applicationList[3] = {nullptr, nullptr, nullptr};
+ReleaseInfoCache Application::_updateInfoCache;
 
 Application::Application(AppId appId) : _appId(appId)
 {
@@ -23,18 +24,76 @@ String Application::getAppIdName(AppId appId)
   return F(CUSTOM_APP_MODEL);
 }
 
+// LittleFS access for ConfigStore
+class LittleFSConfigFS : public ConfigFS
+{
+public:
+  long fileSize(const char *path) override
+  {
+    if (!LittleFS.exists(path))
+      return -1;
+    File file = LittleFS.open(path, "r");
+    if (!file)
+      return -1;
+    long size = file.size();
+    file.close();
+    return size;
+  }
+
+  long readFile(const char *path, uint8_t *buffer, size_t size) override
+  {
+    if (!LittleFS.exists(path))
+      return -1;
+    File file = LittleFS.open(path, "r");
+    if (!file)
+      return -1;
+    long length = file.read(buffer, size);
+    file.close();
+    return length;
+  }
+
+  bool writeFile(const char *path, const uint8_t *data, size_t length) override
+  {
+    File file = LittleFS.open(path, "w");
+    if (!file)
+      return false;
+    bool result = file.write(data, length) == length;
+    file.close();
+    return result;
+  }
+
+  bool rename(const char *from, const char *to) override { return LittleFS.rename(from, to); }
+  bool remove(const char *path) override { return LittleFS.exists(path) && LittleFS.remove(path); }
+};
+
+static LittleFSConfigFS littleFSConfigFS;
+
+ConfigStore Application::configStore()
+{
+  return ConfigStore(littleFSConfigFS, (String('/') + getAppIdName(_appId)).c_str(), getConfigRecordVersion(), getConfigRecordSize());
+}
+
 bool Application::saveConfig()
 {
-  File configFile = LittleFS.open(String('/') + getAppIdName(_appId) + F(".json"), "w");
-  if (!configFile)
+  // JSON config file is always written : it is the one read by previous firmwares (rollback)
+  // and the fallback when binary record format changed
+  String jsonConfig = generateConfigJSON(true);
+
+  uint8_t *record = nullptr;
+  if (getConfigRecordVersion())
   {
-    LOG_SERIAL_PRINTLN(F("Failed to open config file for writing"));
-    return false;
+    record = new uint8_t[getConfigRecordSize()];
+    writeConfigRecord(record);
   }
 
-  configFile.print(generateConfigJSON(true));
-  configFile.close();
-  return true;
+  // both files are written to temporary files then renamed (a power cut never leaves a partial config)
+  bool result = configStore().save(jsonConfig.c_str(), jsonConfig.length(), record);
+  delete[] record;
+
+  if (!result)
+    LOG_ERROR_PRINTLN(F("Failed to write config file"));
+
+  return result;
 }
 
 bool Application::loadConfig()
@@ -43,14 +102,27 @@ bool Application::loadConfig()
   if (_appId == CoreApp)
     return true;
 
+  ConfigStore store = configStore();
+
+  // an interrupted save is completed (or rolled back) first, record is used if it was saved with current JSON file
+  uint8_t *record = getConfigRecordVersion() ? new uint8_t[getConfigRecordSize()] : nullptr;
+  ConfigStore::LoadSource loadSource = store.load(record);
+  if (loadSource == ConfigStore::LoadRecord)
+    readConfigRecord(record);
+  delete[] record;
+
+  if (loadSource != ConfigStore::LoadJson)
+    return loadSource == ConfigStore::LoadRecord;
+
   bool result = false;
-  File configFile = LittleFS.open(String('/') + getAppIdName(_appId) + F(".json"), "r");
+  File configFile = LittleFS.open(store.jsonPath(), "r");
   if (configFile)
   {
 
     JsonDocument jsonDoc;
 
     DeserializationError deserializeJsonError = deserializeJson(jsonDoc, configFile);
+    configFile.close();
 
     // if deserialization failed, then log error and save current config (default values)
     if (deserializeJsonError)
@@ -63,14 +135,36 @@ bool Application::loadConfig()
     else
     { // otherwise pass it to application
       result = parseConfigJSON(jsonDoc);
+
+      // (re)create binary record from JSON config (migration, record format changed or JSON saved by another firmware)
+      if (result && getConfigRecordVersion())
+        saveConfig();
     }
-    configFile.close();
   }
 
   return result;
 }
 
-bool Application::getLastestUpdateInfo(String &version, String &title, String &releaseDate, String &summary)
+bool Application::getLastestUpdateInfo(String &version, String &title, String &releaseDate, String &summary, bool revalidate /* = false */)
+{
+  // reuse cached info if fresh enough (avoid TLS download for each MQTT publish or page load)
+  // revalidate is used by explicit refresh (cheap 304 answer if release didn't change)
+  if (!_updateInfoCache.fresh(millis(), UPDATE_INFO_CACHE_TTL, revalidate))
+    fetchLatestUpdateInfo();
+
+  if (!_updateInfoCache.valid())
+    return false;
+
+  const ReleaseInfo &info = _updateInfoCache.info();
+  version = info.version;
+  title = info.title;
+  releaseDate = info.releaseDate;
+  summary = info.summary;
+  return true;
+}
+
+// request latest release info from GitHub and update cache
+void Application::fetchLatestUpdateInfo()
 {
   String githubURL = F("https://api.github.com/repos/" CUSTOM_APP_MANUFACTURER "/" CUSTOM_APP_MODEL "/releases/latest");
 
@@ -79,133 +173,53 @@ bool Application::getLastestUpdateInfo(String &version, String &title, String &r
 
   clientSecure.setInsecure();
   http.begin(clientSecure, githubURL);
+
+  const char *headerKeys[] = {"ETag"};
+  http.collectHeaders(headerKeys, 1);
+
+  // revalidate cached info (304 answers don't count in GitHub rate limit)
+  if (_updateInfoCache.ifNoneMatch())
+    http.addHeader(F("If-None-Match"), _updateInfoCache.ifNoneMatch());
+
   int httpCode = http.GET();
 
+  // release didn't change, refresh cache timestamp
+  if (httpCode == HTTP_CODE_NOT_MODIFIED && _updateInfoCache.notModified(millis()))
+  {
+    http.end();
+    return;
+  }
+
   // check for http error
   if (httpCode != 200)
   {
     http.end();
-    return false;
+    return;
   }
 
   // httpCode is 200, we can continue
+  String etag = http.header("ETag");
   WiFiClient *stream = http.getStreamPtr();
 
   // We need to parse the JSON response without loading the whole response in memory
-
-  uint8_t maxKeyLength = 16; // longest key is "\"published_at\":"" =>15 chars
-  String keyBuffer;          // Shifting buffer used to find keys
-  uint8_t treeLevel = 0;     // used to skip unwanted data
-  bool keyFound = false;     // used to know if we found a key we are looking for
-  String *targetString = nullptr;
-  size_t targetStringSize = 0;
+  ReleaseInfo *info = new ReleaseInfo;
+  ReleaseInfoParser parser(*info);
 
   // sometime the stream is not yet ready (no data available yet)
   for (byte i = 0; i < 200 && stream->available() == 0; i++) // available include an optimistic_yield of 100us
     ;
 
-  // while there is data to read
-  while (http.connected() && stream->available())
-  {
-    // read the next character
-    char c = stream->read();
-
-    // if c is a brace or bracket, increment or decrement the treeLevel
-    if (c == '{' || c == '[')
-      treeLevel++;
-    else if (c == '}' || c == ']')
-      treeLevel--;
-
-    // if we are not at the first treeLevel, skip the character
-    // (there is some "name" key in assets that we don't want to parse)
-    if (treeLevel > 1)
-      continue;
-
-    // if keyBuffer is full, shift it to the left by one character
-    if (keyBuffer.length() == maxKeyLength)
-      keyBuffer.remove(0, 1);
-
-    // add the new character at the end
-    keyBuffer.concat(c);
-
-    keyFound = false;
-
-    // if we found the key "tag_name"
-    if (c == ':' && keyBuffer.endsWith(F("\"tag_name\":")))
-    {
-      keyFound = true;
-      targetString = &version;
-      targetStringSize = 9;
-    }
-
-    // if we found the key "name"
-    if (c == ':' && keyBuffer.endsWith(F("\"name\":")))
-    {
-      keyFound = true;
-      targetString = &title;
-      targetStringSize = 63;
-    }
-
-    // if we found the key "published_at"
-    if (c == ':' && keyBuffer.endsWith(F("\"published_at\":")))
-    {
-      keyFound = true;
-      targetString = &releaseDate;
-      targetStringSize = 10;
-    }
-
-    // if we found the key "body"
-    if (c == ':' && keyBuffer.endsWith(F("\"body\":")))
-    {
-      keyFound = true;
-      targetString = &summary;
-      targetStringSize = 255;
-    }
-
-    if (keyFound)
-    {
-      // read until the next quote (should be next to semicolon)
-      stream->readStringUntil('"');
-
-      // for name/title key, skip text until the first space
-      if (targetString == &title)
-        stream->readStringUntil(' ');
-
-      // read the value
-      while (stream->available())
-      {
-        c = stream->read();
-
-        if (c == '"' && !targetString->endsWith(F("\\")))
-          break;
-
-        if (targetString->endsWith(F("\\")) && c == 'n')
-          (*targetString)[targetString->length() - 1] = '\n';
-        else if (targetString->endsWith(F("\\")) && c == 'r')
-          (*targetString)[targetString->length() - 1] = '\r';
-        else if (targetString->endsWith(F("\\")) && c == '"')
-          (*targetString)[targetString->length() - 1] = '"';
-        else if (targetString->length() < targetStringSize)
-          targetString->concat(c);
-
-        // for summary, stop at "\r\n\r\n##"
-        if (targetString == &summary && targetString->endsWith(F("\r\n\r\n##")))
-        {
-          // remove the last 6 characters
-          targetString->remove(targetString->length() - 6);
-          // avoid adding more text in summary
-          targetStringSize = targetString->length();
-        }
-      }
-    }
-  }
+  // while there is data to read and some keys are still missing
+  while (http.connected() && stream->available() && parser.feed(stream->read()))
+    ;
 
   http.end();
 
-  return version.length() > 0;
+  _updateInfoCache.update(*info, etag.c_str(), millis());
+  delete info;
 }
 
-String Application::getLatestUpdateInfoJson(bool forWebPage /* = false */)
+String Application::getLatestUpdateInfoJson(bool forWebPage /* = false */, bool revalidate /* = false */)
 {
   JsonDocument doc;
 
@@ -213,7 +227,8 @@ String Application::getLatestUpdateInfoJson(bool forWebPage /* = false */)
 
   String version, title, releaseDate, summary;
 
-  if (getLastestUpdateInfo(version, title, releaseDate, summary))
+  // web page "Refresh" must reflect a new release immediately
+  if (getLastestUpdateInfo(version, title, releaseDate, summary, revalidate))
   {
     doc[F("latest_version")] = version;
     doc[F("title")] = title;
@@ -358,6 +373,8 @@ void Application::initWebServer(WebServer &server)
   server.on(url, HTTP_GET,
             [this, &server]()
             {
+              HEAP_SCOPE(HeapHttp);
+              TRACE_SCOPE("httpStatusJSON");
               SERVER_KEEPALIVE_FALSE()
               server.sendHeader(F("Cache-Control"), F("no-cache"));
               server.send(200, F("text/json"), generateStatusJSON());
@@ -368,6 +385,8 @@ void Application::initWebServer(WebServer &server)
   server.on(url, HTTP_GET,
             [this, &server]()
             {
+              HEAP_SCOPE(HeapHttp);
+              TRACE_SCOPE("httpConfigJSON");
               SERVER_KEEPALIVE_FALSE()
               server.sendHeader(F("Cache-Control"), F("no-cache"));
               server.send(200, F("text/json"), generateConfigJSON());
@@ -377,6 +396,9 @@ void Application::initWebServer(WebServer &server)
   server.on(url, HTTP_POST,
             [this, &server]()
             {
+              HEAP_SCOPE(HeapHttp);
+              TRACE_SCOPE("httpSaveConfig");
+
               // All responses have keep-alive set to false
               SERVER_KEEPALIVE_FALSE()
 
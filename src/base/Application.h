@@ -3,20 +3,29 @@
 
 #include "../Main.h"
 #include "SystemState.h"
+#include "HeapMonitor.h"
+#include "Tracer.h"
 #include <LittleFS.h>
 #ifdef ESP8266
 #include <ESP8266WebServer.h>
 using WebServer = ESP8266WebServer;
-#define SERVER_KEEPALIVE_FALSE() server.keepAlive(false);
+// every handler uses it before answering : no keep-alive and time of the first answer is kept for boot timeline
+#define SERVER_KEEPALIVE_FALSE() \
+  server.keepAlive(false);       \
+  SystemState::markFirstHttpResponse();
 #include <ESP8266HTTPClient.h>
 #else
 #include <WebServer.h>
-#define SERVER_KEEPALIVE_FALSE()
+#define SERVER_KEEPALIVE_FALSE() SystemState::markFirstHttpResponse();
 #include <HTTPClient.h>
 #include <Update.h>
 #endif
 #include <ArduinoJson.h>
 #include <Ticker.h>
+#include "../ConfigStore.h"
+#include "../ReleaseInfo.h"
+
+#define UPDATE_INFO_CACHE_TTL 900000 // latest release info is reused without request during this time (in ms, web page Refresh button revalidates)
 
 class Application
 {
@@ -39,12 +48,19 @@ protected:
   AppId _appId;
   bool _reInit = false;
 
+  // config files (JSON and binary record) of this application
+  ConfigStore configStore();
+
+  // latest release info cache (revalidated using ETag)
+  static ReleaseInfoCache _updateInfoCache;
+  static void fetchLatestUpdateInfo();
+
   // already built methods
   bool saveConfig();
   bool loadConfig();
 
-  static bool getLastestUpdateInfo(String &version, String &title, String &releaseDate, String &summary);
-  static String getLatestUpdateInfoJson(bool forWebPage = false);
+  static bool getLastestUpdateInfo(String &version, String &title, String &releaseDate, String &summary, bool revalidate = false);
+  static String getLatestUpdateInfoJson(bool forWebPage = false, bool revalidate = false);
   static bool updateFirmware(const char *version, String &retMsg, std::function<void(size_t, size_t)> progressCallback = nullptr);
 
   // specialization required from the application
@@ -58,6 +74,12 @@ protected:
   virtual void appInitWebServer(WebServer &server) = 0;
   virtual void appRun() = 0;
 
+  // optional binary config record (loaded without JSON parsing), version 0 means JSON file only
+  virtual uint16_t getConfigRecordVersion() { return 0; };
+  virtual size_t getConfigRecordSize() { return 0; };
+  virtual void writeConfigRecord(void *record) {};
+  virtual void readConfigRecord(const void *record) {};
+
 public:
   Application(AppId appId);
 
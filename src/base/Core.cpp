@@ -2,6 +2,8 @@
 #include <EEPROM.h>
 #include "../Main.h" //for VERSION define
 #include "Version.h" //for BASE_VERSION define
+#include "PerfMonitor.h"
+#include <StreamString.h>
 
 #include "data/index.html.gz.h"
 #include "data/pure-min.css.gz.h"
@@ -29,6 +31,20 @@ String Core::generateStatusJSON()
   doc[F("baseversion")] = BASE_VERSION;
   doc[F("version")] = VERSION;
   doc[F("uptime")] = String((byte)(minutes / 1440)) + 'd' + (byte)(minutes / 60 % 24) + 'h' + (byte)(minutes % 60) + 'm';
+  if (SystemState::firstHttpResponseMillis)
+    doc[F("firsthttpresponse")] = SystemState::firstHttpResponseMillis;
+
+  // setup() phases durations (rescue/fs/core/wifi/custom/web in ms)
+  char setupPhases[64];
+  snprintf_P(setupPhases, sizeof(setupPhases), PSTR("%lu/%lu/%lu/%lu/%lu/%lu"),
+             SystemState::setupPhaseMillis[SystemState::SetupRescue],
+             SystemState::setupPhaseMillis[SystemState::SetupFileSystem],
+             SystemState::setupPhaseMillis[SystemState::SetupCore],
+             SystemState::setupPhaseMillis[SystemState::SetupWiFi],
+             SystemState::setupPhaseMillis[SystemState::SetupCustom],
+             SystemState::setupPhaseMillis[SystemState::SetupWebServer]);
+  doc[F("setupphases")] = setupPhases;
+  doc[F("setupend")] = SystemState::setupPhaseStartMillis;
   doc[F("freeheap")] = ESP.getFreeHeap();
 #ifdef ESP8266
   doc[F("freestack")] = ESP.getFreeContStack();
@@ -36,6 +52,14 @@ String Core::generateStatusJSON()
 #else
   doc[F("freestack")] = uxTaskGetStackHighWaterMark(nullptr);
 #endif
+#if HEAP_MONITOR_ENABLED
+  HeapMonitor::fillStatusJSON(doc);
+#endif
+#if defined(LOG_SERIAL) && LOG_ASYNC_ENABLED
+  doc[F("logwritten")] = Log.getWrittenBytes();
+  doc[F("logdropped")] = Log.getDroppedBytes();
+  doc[F("logmaxdrain")] = Log.getMaxDrainMicros();
+#endif
 
   String gs;
   serializeJson(doc, gs);
@@ -44,8 +68,21 @@ String Core::generateStatusJSON()
 }
 bool Core::appInit(bool reInit = false)
 {
+#if defined(LOG_SERIAL) && LOG_ASYNC_ENABLED && EVTSRC_ENABLED
+  // forward log lines to status page
+  Log.setLineHandler([this](const char *line)
+                     { _eventSourceMan.eventSourceBroadcast(line, F("log")); });
+#endif
+
   return true;
 };
+void Core::appRun()
+{
+#if EVTSRC_ENABLED
+  // send pending events and remove dead clients
+  _eventSourceMan.run();
+#endif
+}
 const PROGMEM char *Core::getHTMLContent(WebPageForPlaceHolder wp)
 {
   switch (wp)
@@ -119,13 +156,57 @@ void Core::appInitWebServer(WebServer &server)
               server.send_P(200, PSTR("text/html"), fwhtmlgz, sizeof(fwhtmlgz));
             });
 
+#if defined(LOG_SERIAL) && LOG_ASYNC_ENABLED
+  // last log lines still in RAM buffer
+  server.on(F("/log"), HTTP_GET,
+            [&server]()
+            {
+              StreamString tail;
+              tail.reserve(LOG_BUFFER_SIZE);
+              Log.printTail(tail);
+
+              SERVER_KEEPALIVE_FALSE()
+              server.send(200, F("text/plain"), tail);
+            });
+#endif
+
+#if PERF_ENABLED
+  // main loop stages timing (?reset to restart measures)
+  server.on(F("/perf"), HTTP_GET,
+            [&server]()
+            {
+              SERVER_KEEPALIVE_FALSE()
+              server.send(200, F("application/json"), PerfMonitor::generateJSON());
+
+              if (server.hasArg(F("reset")))
+                PerfMonitor::reset();
+            });
+#endif
+
+#if TRACE_ENABLED
+  // recorded trace events (Chrome trace_event format)
+  server.on(F("/trace"), HTTP_GET,
+            [&server]()
+            {
+              SERVER_KEEPALIVE_FALSE()
+              server.sendHeader(F("Content-Disposition"), F("attachment; filename=\"trace.json\""));
+              Tracer::streamJSON(server);
+            });
+#endif
+
+#if EVTSRC_ENABLED
+  // live log lines
+  _eventSourceMan.initEventSourceServer(getAppIdChar(_appId), server);
+#endif
+
   // Get Latest Update Info ---------------------------------------------------------
   server.on(
       F("/glui"), HTTP_GET,
       [this, &server]()
       {
+        // served from cache unless the page asks for a refresh
         SERVER_KEEPALIVE_FALSE()
-        server.send(200, F("application/json"), getLatestUpdateInfoJson(true));
+        server.send(200, F("application/json"), getLatestUpdateInfoJson(true, server.hasArg(F("refresh"))));
       });
 
   // Update Firmware from Github ----------------------------------------------
@@ -143,7 +224,7 @@ void Core::appInitWebServer(WebServer &server)
         std::function<void(size_t, size_t)> progressCallback = [&server](size_t progress, size_t total)
         {
           uint8_t percent = (progress * 100) / total;
-          LOG_SERIAL_PRINTF_P(PSTR("Progress: %d%%\n"), percent);
+          LOG_DEBUG_PRINTF_P(PSTR("Progress: %d%%\n"), percent);
           server.sendContent((String(F("p:")) + percent + '\n').c_str());
         };
 
@@ -3,6 +3,7 @@
 
 #include "../Main.h"
 #include "Application.h"
+#include "EventSourceMan.h"
 
 #include "data/status0.html.gz.h"
 #include "data/config0.html.gz.h"
@@ -11,6 +12,10 @@
 class Core : public Application
 {
 private:
+#if EVTSRC_ENABLED
+  EventSourceMan _eventSourceMan;
+#endif
+
   void setConfigDefaultValues();
   bool parseConfigJSON(JsonDocument &doc, bool fromWebPage);
   String generateConfigJSON(bool forSaveFile);
@@ -19,7 +24,7 @@ private:
   const PROGMEM char *getHTMLContent(WebPageForPlaceHolder wp);
   size_t getHTMLContentSize(WebPageForPlaceHolder wp);
   void appInitWebServer(WebServer &server);
-  void appRun() {};
+  void appRun();
 
 public:
   Core() : Application(CoreApp) {};
@@ -2,62 +2,134 @@
 
 #if EVTSRC_ENABLED
 
+#ifndef ESP8266
+#include <lwip/sockets.h>
+#endif
+
+// queue data in client buffer, return false if there is not enough room
+bool EventSourceMan::enqueue(EventSourceClient &client, const char *data, size_t length)
+{
+    if (client.length + length > EVTSRC_CLIENT_BUFFER_SIZE)
+        return false;
+
+    if (!client.length)
+        client.lastProgressMillis = millis();
+
+    memcpy(client.buffer + client.length, data, length);
+    client.length += length;
+    client.lastWriteMillis = millis();
+    return true;
+}
+
+// send as much pending data as the socket accepts without waiting, return false if socket is dead
+bool EventSourceMan::flush(EventSourceClient &client)
+{
+    if (!client.client.connected())
+        return false;
+
+    if (!client.length)
+        return true;
+
+#ifdef ESP8266
+    size_t sent = client.client.availableForWrite();
+    if (sent > client.length)
+        sent = client.length;
+    if (sent)
+        sent = client.client.write((const uint8_t *)client.buffer, sent);
+#else
+    int sent = send(client.client.fd(), client.buffer, client.length, MSG_DONTWAIT);
+    if (sent < 0)
+    {
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+            return false;
+        sent = 0;
+    }
+#endif
+
+    if (sent)
+    {
+        client.length -= sent;
+        memmove(client.buffer, client.buffer + sent, client.length);
+        client.lastProgressMillis = millis();
+    }
+
+    return true;
+}
+
+void EventSourceMan::evict(EventSourceClient &client)
+{
+    client.client.stop();
+    delete[] client.buffer;
+    client.buffer = nullptr;
+    client.length = 0;
+    client.drops = 0;
+}
+
 void EventSourceMan::eventSourceHandler(WebServer &server)
 {
     uint8_t subPos = 0;
 
     // Find the subscription for this client
     while (subPos < EVTSRC_MAX_CLIENTS &&
-           (!_EventSourceClientList[subPos] ||
-            _EventSourceClientList[subPos].remoteIP() != server.client().remoteIP() ||
-            _EventSourceClientList[subPos].remotePort() != server.client().remotePort()))
+           (!_clients[subPos].buffer ||
+            _clients[subPos].client.remoteIP() != server.client().remoteIP() ||
+            _clients[subPos].client.remotePort() != server.client().remotePort()))
         subPos++;
 
     // If no subscription found
     if (subPos == EVTSRC_MAX_CLIENTS)
     {
+        // each client needs its buffer and TCP buffers, keep some heap for everything else
+        if (ESP.getFreeHeap() < EVTSRC_CLIENT_BUFFER_SIZE + EVTSRC_HEAP_RESERVE)
+            return server.send(503);
+
         subPos = 0;
         // Find a free slot
-        while (subPos < EVTSRC_MAX_CLIENTS && _EventSourceClientList[subPos])
+        while (subPos < EVTSRC_MAX_CLIENTS && _clients[subPos].buffer)
             subPos++;
 
         // If there is no more slot available
         if (subPos == EVTSRC_MAX_CLIENTS)
-            return server.send(500);
+            return server.send(503);
+
+        _clients[subPos].buffer = new char[EVTSRC_CLIENT_BUFFER_SIZE];
     }
 
-#ifdef ESP8266
-    server.client().setSync(true); // disable Nagle's algorithm and flush immediately
-#else
+    EventSourceClient &client = _clients[subPos];
+
+    // writes are done without waiting (Nagle disabled so small events go out immediately)
     server.client().setNoDelay(true);
-#endif
 
     // create/update subscription
-    _EventSourceClientList[subPos] = server.client();
+    client.client = server.client();
+    client.length = 0;
+    client.drops = 0;
     server.setContentLength(CONTENT_LENGTH_UNKNOWN); // the payload can go on forever
     server.sendContent_P(PSTR("HTTP/1.1 200 OK\nContent-Type: text/event-stream;\nConnection: keep-alive\nCache-Control: no-cache\nAccess-Control-Allow-Origin: *\n\n"));
 
-#if DEVELOPPER_MODE
-    LOG_SERIAL_PRINTF_P(PSTR("statusEventSourceHandler - client #%d (%s:%d) registered\n"), subPos, server.client().remoteIP().toString().c_str(), server.client().remotePort());
-#endif
-}
-
-#if EVTSRC_KEEPALIVE_ENABLED
-void EventSourceMan::eventSourceKeepAlive()
-{
-    for (uint8_t i = 0; i < EVTSRC_MAX_CLIENTS; i++)
+    // reconnecting browser gives the last event it received : replay the ones it missed (if still in backlog)
+    String lastEventId = server.header(F("Last-Event-ID"));
+    if (!lastEventId.length())
+        lastEventId = server.arg(F("lastEventId"));
+    if (lastEventId.length())
     {
-        if (_EventSourceClientList[i])
+        uint32_t eventId = lastEventId.toInt() + 1;
+        if (eventId + EVTSRC_BACKLOG_EVENTS <= _lastEventId)
+            eventId = _lastEventId - EVTSRC_BACKLOG_EVENTS + 1;
+
+        for (; eventId <= _lastEventId; eventId++)
         {
-            _EventSourceClientList[i].println(F(":keepalive\n\n"));
+            const String &frame = _backlog[eventId % EVTSRC_BACKLOG_EVENTS];
+            if (!enqueue(client, frame.c_str(), frame.length()))
+                break;
+        }
+        flush(client);
+    }
 
 #if DEVELOPPER_MODE
-            LOG_SERIAL_PRINTF_P(PSTR("statusEventSourceKeepAlive - keep-alive sent to client #%d (%s:%d)\n"), i, _EventSourceClientList[i].remoteIP().toString().c_str(), _EventSourceClientList[i].remotePort());
+    LOG_SERIAL_PRINTF_P(PSTR("statusEventSourceHandler - client #%d (%s:%d) registered\n"), subPos, server.client().remoteIP().toString().c_str(), server.client().remotePort());
 #endif
-        }
-    }
 }
-#endif
 
 void EventSourceMan::initEventSourceServer(char appIdChar, WebServer &server)
 {
@@ -66,42 +138,85 @@ void EventSourceMan::initEventSourceServer(char appIdChar, WebServer &server)
     // register EventSource Uri
     server.on(url, HTTP_GET, [this, &server]()
               { eventSourceHandler(server); });
-#if EVTSRC_KEEPALIVE_ENABLED
-    // send keep alive event every 60 seconds
-#ifdef ESP8266
-    _eventSourceKeepAliveTicker.attach(60, [this]()
-                                       { _needEventSourceKeepAlive = true; });
-#else
-    _eventSourceKeepAliveTicker.attach<typeof this>(60, [](typeof this eventSourceMan)
-                                                    { eventSourceMan->_needEventSourceKeepAlive = true; }, this);
-#endif
-#endif
 }
 
 void EventSourceMan::eventSourceBroadcast(const String &message, const String &eventType) // default eventType is "message"
 {
+    _lastEventId++;
+
+    // frame is formatted once, kept for replay and queued to each client
+    String &frame = _backlog[_lastEventId % EVTSRC_BACKLOG_EVENTS];
+    frame = F("id: ");
+    frame += _lastEventId;
+    frame += F("\nevent: ");
+    frame += eventType;
+    frame += F("\ndata: ");
+    frame += message;
+    frame += F("\n\n");
+
     for (uint8_t i = 0; i < EVTSRC_MAX_CLIENTS; i++)
     {
-        if (_EventSourceClientList[i])
+        EventSourceClient &client = _clients[i];
+        if (!client.buffer)
+            continue;
+
+        // slow consumer : drop the event, then evict the client (browser will reconnect and replay with Last-Event-ID)
+        if (!enqueue(client, frame.c_str(), frame.length()))
         {
-            _EventSourceClientList[i].printf_P(PSTR("event: %s\ndata: %s\n\n"), eventType.c_str(), message.c_str());
+            if (++client.drops > EVTSRC_MAX_DROPS)
+            {
+                LOG_DEBUG_PRINTF_P(PSTR("EventSource client #%d evicted (too slow)\n"), i);
+                evict(client);
+                _evictedClients++;
+            }
+            continue;
+        }
+        client.drops = 0;
+
+        if (!flush(client))
+            evict(client);
 
 #if DEVELOPPER_MODE
+        // log events are forwarded by Log itself : logging them would produce a new log event for each one
+        if (eventType != F("log"))
             LOG_SERIAL_PRINTF_P(PSTR("statusEventSourceBroadcast - event sent to client #%d\n"), i);
 #endif
-        }
     }
 }
 
-#if EVTSRC_KEEPALIVE_ENABLED
+uint8_t EventSourceMan::getClientCount()
+{
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < EVTSRC_MAX_CLIENTS; i++)
+        if (_clients[i].buffer)
+            count++;
+    return count;
+}
+
+// send pending data, ping idle clients and remove dead ones
 void EventSourceMan::run()
 {
-    if (_needEventSourceKeepAlive)
+    for (uint8_t i = 0; i < EVTSRC_MAX_CLIENTS; i++)
     {
-        _needEventSourceKeepAlive = false;
-        eventSourceKeepAlive();
+        EventSourceClient &client = _clients[i];
+        if (!client.buffer)
+            continue;
+
+        // a comment line is enough to detect a dead socket
+        if (millis() - client.lastWriteMillis > EVTSRC_PING_INTERVAL)
+            enqueue(client, ":\n\n", 3);
+
+        // socket closed
+        if (!flush(client))
+            evict(client);
+        // nothing sent for too long (peer gone without closing or too slow)
+        else if (client.length && millis() - client.lastProgressMillis > EVTSRC_STALL_TIMEOUT)
+        {
+            LOG_DEBUG_PRINTF_P(PSTR("EventSource client #%d evicted (stalled)\n"), i);
+            evict(client);
+            _evictedClients++;
+        }
     }
 }
-#endif // EVTSRC_KEEPALIVE_ENABLED
 
-#endif // EVTSRC_ENABLED
\ No newline at end of file
+#endif // EVTSRC_ENABLED
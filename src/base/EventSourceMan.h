@@ -11,34 +11,43 @@ using WebServer = ESP8266WebServer;
 #include <WebServer.h>
 #endif
 
-#include <Ticker.h>
-
 class EventSourceMan
 {
 private:
 #if EVTSRC_ENABLED
-    WiFiClient _EventSourceClientList[EVTSRC_MAX_CLIENTS];
+    typedef struct
+    {
+        WiFiClient client;
+        char *buffer = nullptr; // pending bytes (allocated while client is registered)
+        uint16_t length = 0;
+        uint8_t drops = 0;                  // consecutive events dropped because buffer was full
+        unsigned long lastProgressMillis = 0; // last time pending bytes were sent (or buffer was empty)
+        unsigned long lastWriteMillis = 0;    // last time something was queued (for ping)
+    } EventSourceClient;
 
-    void eventSourceHandler(WebServer &server);
-    
-#if EVTSRC_KEEPALIVE_ENABLED
-    bool _needEventSourceKeepAlive = false;
-    Ticker _eventSourceKeepAliveTicker;
+    EventSourceClient _clients[EVTSRC_MAX_CLIENTS];
 
-    void eventSourceKeepAlive();
-#endif
+    // last events kept for Last-Event-ID replay
+    uint32_t _lastEventId = 0;
+    String _backlog[EVTSRC_BACKLOG_EVENTS];
+
+    uint32_t _evictedClients = 0;
+
+    void eventSourceHandler(WebServer &server);
+    bool enqueue(EventSourceClient &client, const char *data, size_t length);
+    bool flush(EventSourceClient &client);
+    void evict(EventSourceClient &client);
 #endif
 
 public:
 #if EVTSRC_ENABLED
     void initEventSourceServer(char appIdChar, WebServer &server);
     void eventSourceBroadcast(const String &message, const String &eventType = "message");
-
-#if EVTSRC_KEEPALIVE_ENABLED
+    uint8_t getClientCount();
+    uint32_t getEvictedClients() { return _evictedClients; };
 
     void run();
 #endif
-#endif
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,126 @@
+#include "HeapMonitor.h"
+
+#if HEAP_MONITOR_ENABLED
+
+// Tag names (same order as Tag enum)
+static const char tagNames[][12] PROGMEM = {
+    "http",
+    "stovecmd",
+    "mqttpublish",
+    "discovery"};
+
+HeapMonitor::TagStats HeapMonitor::_tagStats[HeapTagCount];
+uint32_t HeapMonitor::_minFreeHeap = UINT32_MAX;
+uint32_t HeapMonitor::_minMaxFreeBlock = UINT32_MAX;
+uint8_t HeapMonitor::_maxFragmentation = 0;
+unsigned long HeapMonitor::_lastSampleMillis = 0;
+
+HeapScope *HeapScope::_current = nullptr;
+
+HeapScope::~HeapScope()
+{
+  int32_t retainedBytes = (int32_t)_freeHeapAtEntry - (int32_t)ESP.getFreeHeap();
+
+  // this scope only owns what its nested scopes didn't retain, parent scope will do the same
+  HeapMonitor::record(_tag, retainedBytes - _childRetainedBytes);
+  if (_parent)
+    _parent->_childRetainedBytes += retainedBytes;
+
+  _current = _parent;
+}
+
+uint32_t HeapMonitor::getMaxFreeBlock()
+{
+#ifdef ESP8266
+  return ESP.getMaxFreeBlockSize();
+#else
+  return ESP.getMaxAllocHeap();
+#endif
+}
+
+uint8_t HeapMonitor::getFragmentation()
+{
+#ifdef ESP8266
+  return ESP.getHeapFragmentation();
+#else
+  uint32_t freeHeap = ESP.getFreeHeap();
+  return freeHeap ? 100 - (uint64_t)getMaxFreeBlock() * 100 / freeHeap : 0;
+#endif
+}
+
+void HeapMonitor::sample(bool force)
+{
+  // walking the heap to find max free block is not free, so sample only periodically
+  if (!force && millis() - _lastSampleMillis < HEAP_SAMPLE_INTERVAL)
+    return;
+  _lastSampleMillis = millis();
+
+  uint32_t freeHeap = ESP.getFreeHeap();
+  uint32_t maxFreeBlock = getMaxFreeBlock();
+  uint8_t fragmentation = getFragmentation();
+
+  if (freeHeap < _minFreeHeap)
+    _minFreeHeap = freeHeap;
+  if (maxFreeBlock < _minMaxFreeBlock)
+    _minMaxFreeBlock = maxFreeBlock;
+  if (fragmentation > _maxFragmentation)
+    _maxFragmentation = fragmentation;
+}
+
+void HeapMonitor::record(Tag tag, int32_t retainedBytes)
+{
+  uint32_t freeHeap = ESP.getFreeHeap();
+  TagStats &stats = _tagStats[tag];
+
+  stats.count++;
+  stats.retainedBytes += retainedBytes;
+  if (retainedBytes > 0 && (uint32_t)retainedBytes > stats.maxRetainedBytes)
+    stats.maxRetainedBytes = retainedBytes;
+
+  // free heap low-water mark is also updated on scope exit since it is when heap is the most used
+  if (freeHeap < _minFreeHeap)
+    _minFreeHeap = freeHeap;
+}
+
+void HeapMonitor::fillStatusJSON(JsonDocument &doc)
+{
+  doc[F("maxfreeblock")] = getMaxFreeBlock();
+  doc[F("heapfragmentation")] = getFragmentation();
+#ifdef ESP8266
+  if (_minFreeHeap != UINT32_MAX)
+    doc[F("minfreeheap")] = _minFreeHeap;
+#else
+  doc[F("minfreeheap")] = ESP.getMinFreeHeap();
+#endif
+  if (_minMaxFreeBlock != UINT32_MAX)
+    doc[F("minmaxfreeblock")] = _minMaxFreeBlock;
+  doc[F("maxheapfragmentation")] = _maxFragmentation;
+}
+
+String HeapMonitor::generateJSON()
+{
+  JsonDocument doc;
+  char tagName[sizeof(tagNames[0])];
+
+  doc[F("freeheap")] = ESP.getFreeHeap();
+  fillStatusJSON(doc);
+
+  for (uint8_t i = 0; i < HeapTagCount; i++)
+  {
+    if (!_tagStats[i].count)
+      continue;
+
+    strcpy_P(tagName, tagNames[i]);
+    JsonObject tag = doc[F("tags")][tagName].to<JsonObject>();
+    tag[F("n")] = _tagStats[i].count;
+    tag[F("retained")] = _tagStats[i].retainedBytes;
+    tag[F("maxretained")] = _tagStats[i].maxRetainedBytes;
+  }
+
+  String gs;
+  serializeJson(doc, gs);
+
+  return gs;
+}
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef HeapMonitor_h
+#define HeapMonitor_h
+
+#include "../Main.h"
+#include <ArduinoJson.h>
+
+#if HEAP_MONITOR_ENABLED
+
+// Interval between two heap samples (in ms)
+#define HEAP_SAMPLE_INTERVAL 1000
+
+class HeapMonitor
+{
+public:
+  typedef enum
+  {
+    HeapHttp = 0,
+    HeapStoveCmd,
+    HeapMqttPublish,
+    HeapDiscovery,
+    HeapTagCount
+  } Tag;
+
+private:
+  typedef struct
+  {
+    uint32_t count;
+    int32_t retainedBytes;     // sum of heap not given back at scope exit (nested scopes excluded)
+    uint32_t maxRetainedBytes; // biggest heap not given back by a single scope (nested scopes excluded)
+  } TagStats;
+
+  static TagStats _tagStats[HeapTagCount];
+  static uint32_t _minFreeHeap;
+  static uint32_t _minMaxFreeBlock;
+  static uint8_t _maxFragmentation;
+  static unsigned long _lastSampleMillis;
+
+public:
+  static uint32_t getMaxFreeBlock();
+  static uint8_t getFragmentation();
+
+  static void sample(bool force = false);
+  static void record(Tag tag, int32_t retainedBytes);
+  static void fillStatusJSON(JsonDocument &doc);
+  static String generateJSON();
+};
+
+// Attribute heap consumption of the enclosing scope to a subsystem
+// Heap retained by nested scopes is only counted in the innermost one.
+// On ESP32, free heap is global so deltas also include allocations made meanwhile by other tasks (stove, UART, WiFi).
+class HeapScope
+{
+private:
+  static HeapScope *_current; // innermost active scope (scopes are only used from loop task)
+
+  HeapMonitor::Tag _tag;
+  uint32_t _freeHeapAtEntry;
+  HeapScope *_parent;
+  int32_t _childRetainedBytes = 0;
+
+public:
+  HeapScope(HeapMonitor::Tag tag) : _tag(tag), _freeHeapAtEntry(ESP.getFreeHeap()), _parent(_current) { _current = this; };
+  ~HeapScope();
+};
+
+#define HEAP_CONCAT_(a, b) a##b
+#define HEAP_CONCAT(a, b) HEAP_CONCAT_(a, b)
+#define HEAP_SCOPE(tag) HeapScope HEAP_CONCAT(heapScope, __LINE__)(HeapMonitor::tag)
+
+#else
+#define HEAP_SCOPE(tag)
+#endif
+
+#endif
@@ -0,0 +1,173 @@
+#include "Logger.h"
+
+#if defined(LOG_SERIAL) && LOG_ASYNC_ENABLED
+
+#ifdef LOG_SYSLOG_SERVER
+#ifdef ESP8266
+#include <ESP8266WiFi.h>
+#else
+#include <WiFi.h>
+#endif
+#include <WiFiUdp.h>
+
+#ifndef LOG_SYSLOG_PORT
+#define LOG_SYSLOG_PORT 514
+#endif
+
+static WiFiUDP syslogUdp;
+#endif
+
+Logger Log;
+
+size_t Logger::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+size_t Logger::write(const uint8_t *buffer, size_t size)
+{
+#ifndef ESP8266
+  portENTER_CRITICAL(&_mux);
+#endif
+
+  uint32_t head = _head;
+  for (size_t i = 0; i < size; i++)
+    _buffer[(head + i) % LOG_BUFFER_SIZE] = buffer[i];
+  _head = head + size;
+
+#ifndef ESP8266
+  portEXIT_CRITICAL(&_mux);
+#endif
+
+  return size;
+}
+
+void Logger::drainSerial(uint32_t head)
+{
+  // serial is too late, oldest bytes have already been overwritten
+  if (head - _serialPos > LOG_BUFFER_SIZE)
+  {
+    _droppedBytes += head - _serialPos - LOG_BUFFER_SIZE;
+    _serialPos = head - LOG_BUFFER_SIZE;
+  }
+
+  // send only what TX FIFO can accept right now
+  while (_serialPos != head)
+  {
+    size_t available = LOG_SERIAL.availableForWrite();
+    if (!available)
+      break;
+
+    size_t offset = _serialPos % LOG_BUFFER_SIZE;
+    size_t length = head - _serialPos;
+    if (length > LOG_BUFFER_SIZE - offset)
+      length = LOG_BUFFER_SIZE - offset;
+    if (length > available)
+      length = available;
+
+    _serialPos += LOG_SERIAL.write((const uint8_t *)_buffer + offset, length);
+  }
+}
+
+void Logger::forwardLines(uint32_t head)
+{
+  if (head - _linePos > LOG_BUFFER_SIZE)
+  {
+    _linePos = head - LOG_BUFFER_SIZE;
+    _lineLength = 0;
+  }
+
+  while (_linePos != head)
+  {
+    char c = _buffer[_linePos++ % LOG_BUFFER_SIZE];
+
+    if (c == '\r')
+      continue;
+
+    if (c != '\n')
+    {
+      // too long lines are truncated
+      if (_lineLength < LOG_LINE_MAX_LENGTH)
+        _line[_lineLength++] = c;
+      continue;
+    }
+
+    _line[_lineLength] = 0;
+    _lineLength = 0;
+
+    if (!_line[0])
+      continue;
+
+    if (_lineHandler)
+      _lineHandler(_line);
+
+#ifdef LOG_SYSLOG_SERVER
+    if (WiFi.isConnected())
+    {
+      // <14> : facility user, severity informational
+      syslogUdp.beginPacket(LOG_SYSLOG_SERVER, LOG_SYSLOG_PORT);
+      syslogUdp.print(F("<14>" CUSTOM_APP_MODEL ": "));
+      syslogUdp.print(_line);
+      syslogUdp.endPacket();
+    }
+#endif
+  }
+}
+
+void Logger::printTail(Print &out)
+{
+  uint32_t head = _head;
+  uint32_t pos = (head > LOG_BUFFER_SIZE) ? head - LOG_BUFFER_SIZE : 0;
+
+  // oldest line is probably incomplete, skip it
+  if (pos)
+    while (pos != head && _buffer[pos++ % LOG_BUFFER_SIZE] != '\n')
+      ;
+
+  while (pos != head)
+  {
+    size_t offset = pos % LOG_BUFFER_SIZE;
+    size_t length = head - pos;
+    if (length > LOG_BUFFER_SIZE - offset)
+      length = LOG_BUFFER_SIZE - offset;
+
+    out.write((const uint8_t *)_buffer + offset, length);
+    pos += length;
+  }
+}
+
+void Logger::run()
+{
+  unsigned long startMicros = micros();
+
+  // work on a snapshot : bytes written meanwhile (by sinks or by the stove bus task) are handled at next run
+  // (sinks must not log for each forwarded line, it would never end)
+#ifndef ESP8266
+  portENTER_CRITICAL(&_mux);
+#endif
+  uint32_t head = _head;
+#ifndef ESP8266
+  portEXIT_CRITICAL(&_mux);
+#endif
+
+  drainSerial(head);
+  forwardLines(head);
+
+  unsigned long drainMicros = micros() - startMicros;
+  if (drainMicros > _maxDrainMicros)
+    _maxDrainMicros = drainMicros;
+}
+
+void Logger::flush()
+{
+  // blocking drain (used before reboot)
+  uint32_t head = _head;
+  while (_serialPos != head)
+  {
+    drainSerial(head);
+    yield();
+  }
+  LOG_SERIAL.flush();
+}
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef Logger_h
+#define Logger_h
+
+#include "../Main.h"
+
+#if defined(LOG_SERIAL) && LOG_ASYNC_ENABLED
+
+#include <functional>
+
+// Asynchronous log output :
+// log macros write into a RAM ring buffer which is drained to LOG_SERIAL from loop()
+// only as much as the UART TX FIFO can accept, so logging never blocks the caller.
+// Completed lines are also forwarded to an optional line handler (EventSource) and syslog server.
+class Logger : public Print
+{
+public:
+  typedef std::function<void(const char *line)> LineHandler;
+
+private:
+  char _buffer[LOG_BUFFER_SIZE];
+  volatile uint32_t _head = 0;  // total number of bytes written into the buffer since boot
+  uint32_t _serialPos = 0;      // position of the next byte to send to LOG_SERIAL
+  uint32_t _linePos = 0;        // position of the next byte to forward to line sinks
+  char _line[LOG_LINE_MAX_LENGTH + 1];
+  size_t _lineLength = 0;
+  LineHandler _lineHandler = nullptr;
+
+  uint32_t _droppedBytes = 0;       // bytes overwritten before being sent to LOG_SERIAL
+  unsigned long _maxDrainMicros = 0; // longest time spent in a single run()
+
+#ifndef ESP8266
+  portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+  void drainSerial(uint32_t head);
+  void forwardLines(uint32_t head);
+
+public:
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+
+  void setLineHandler(LineHandler lineHandler) { _lineHandler = lineHandler; };
+  void printTail(Print &out);
+  uint32_t getWrittenBytes() { return _head; };
+  uint32_t getDroppedBytes() { return _droppedBytes; };
+  unsigned long getMaxDrainMicros() { return _maxDrainMicros; };
+
+  void run();
+  void flush();
+};
+
+extern Logger Log;
+
+#endif // defined(LOG_SERIAL) && LOG_ASYNC_ENABLED
+
+#endif
@@ -46,6 +46,8 @@ bool MQTTMan::connect(bool firstConnection)
 
     if (connected())
     {
+        SystemState::markBootPhase(SystemState::BootMqttConnected);
+
         if (_connectedAndWillTopic[0])
             publish(_connectedAndWillTopic, "1", true);
 
@@ -163,6 +165,15 @@ bool MQTTMan::loop()
         if (!connected() && !(_mqttReconnectTicker.active() || _needMqttReconnect) && _disconnectedCallBack)
             _disconnectedCallBack();
 
+        // WiFi just came up : reconnect now instead of waiting for reconnect ticker
+        bool wifiConnected = WiFi.isConnected();
+        if (wifiConnected && !_wifiWasConnected && !connected())
+        {
+            _mqttReconnectTicker.detach();
+            _needMqttReconnect = true;
+        }
+        _wifiWasConnected = wifiConnected;
+
         if (_needMqttReconnect)
         {
             _needMqttReconnect = false;
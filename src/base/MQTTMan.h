@@ -2,6 +2,7 @@
 #define MQTTMan_h
 
 #include "../Main.h"
+#include "SystemState.h"
 #ifdef ESP8266
 #include <ESP8266WiFi.h>
 #else
@@ -21,6 +22,7 @@ private:
     char _password[64] = {0};
     char _connectedAndWillTopic[96] = {0};
     bool _needMqttReconnect = false;
+    bool _wifiWasConnected = false;
     Ticker _mqttReconnectTicker;
 
     CONNECTED_CALLBACK_SIGNATURE _connectedCallBack = nullptr;
@@ -13,6 +13,8 @@ using WebServer = ESP8266WebServer;
 #include "Version.h"
 #include "../Main.h"
 #include "SystemState.h"
+#include "PerfMonitor.h"
+#include "HeapMonitor.h"
 #include "Application.h"
 #include "Core.h"
 #include "WifiMan.h"
@@ -87,24 +89,31 @@ void setup()
   {
     LOG_SERIAL_PRINTLN(F("-> RESCUE MODE : Stored configuration won't be loaded."));
   }
+  SystemState::endSetupPhase(SystemState::SetupRescue);
+
 #ifdef ESP8266
   if (!LittleFS.begin())
 #else
   if (!LittleFS.begin(true))
 #endif
   {
-    LOG_SERIAL_PRINTLN(F("/!\\   File System Mount Failed   /!\\"));
-    LOG_SERIAL_PRINTLN(F("/!\\ Configuration can't be saved /!\\"));
+    LOG_ERROR_PRINTLN(F("/!\\   File System Mount Failed   /!\\"));
+    LOG_ERROR_PRINTLN(F("/!\\ Configuration can't be saved /!\\"));
   }
 
+  SystemState::endSetupPhase(SystemState::SetupFileSystem);
+
   // Init Core
   core.init(skipExistingConfig);
+  SystemState::endSetupPhase(SystemState::SetupCore);
 
   // Init WiFi
   wifiMan.init(skipExistingConfig);
+  SystemState::endSetupPhase(SystemState::SetupWiFi);
 
   // Init Custom Application
   custom.init(skipExistingConfig);
+  SystemState::endSetupPhase(SystemState::SetupCustom);
 
   LOG_SERIAL_PRINT(F("Start WebServer : "));
 
@@ -112,9 +121,15 @@ void setup()
   wifiMan.initWebServer(server);
   custom.initWebServer(server);
 
+  // request headers used by handlers (EventSource reconnection)
+  const char *headerKeys[] = {"Last-Event-ID"};
+  server.collectHeaders(headerKeys, sizeof(headerKeys) / sizeof(headerKeys[0]));
+
   server.begin();
+  SystemState::endSetupPhase(SystemState::SetupWebServer);
 
   LOG_SERIAL_PRINTLN(F("OK"));
+
   LOG_SERIAL_PRINTLN(F("---End of setup()---"));
 }
 
@@ -123,19 +138,47 @@ void setup()
 //-----------------------------------------------------------------------
 void loop(void)
 {
+  PERF_SCOPE(StageLoop);
 
   // Handle WebServer
-  server.handleClient();
+  {
+    PERF_SCOPE(StageHttp);
+    server.handleClient();
+  }
 
   if (!SystemState::pauseCustomApp && !SystemState::shouldReboot)
+  {
+    PERF_SCOPE(StageCustomApp);
     custom.run();
+  }
+
+  {
+    PERF_SCOPE(StageWifi);
+    wifiMan.run();
+  }
 
-  wifiMan.run();
+  core.run();
+
+#if HEAP_MONITOR_ENABLED
+  // keep heap low-water marks
+  HeapMonitor::sample();
+#endif
+
+#if defined(LOG_SERIAL) && LOG_ASYNC_ENABLED
+  // send buffered log to serial (without waiting)
+  {
+    PERF_SCOPE(StageLog);
+    Log.run();
+  }
+#endif
 
   if (SystemState::shouldReboot)
   {
 #ifdef LOG_SERIAL
     LOG_SERIAL_PRINTLN(F("Rebooting..."));
+#if LOG_ASYNC_ENABLED
+    Log.flush();
+#endif
     delay(100);
     LOG_SERIAL.end();
 #endif
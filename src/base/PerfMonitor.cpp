@@ -0,0 +1,133 @@
+#include "PerfMonitor.h"
+
+#if PERF_ENABLED
+
+#include <ArduinoJson.h>
+
+// Stage names (same order as Stage enum)
+static const char stageNames[][12] PROGMEM = {
+    "loop",
+    "http",
+    "customapp",
+    "wifi",
+    "log",
+    "mqtt",
+    "discovery",
+    "update",
+    "stoveattach",
+    "stove",
+    "publish",
+    "busresults",
+    "udp",
+    "websocket"};
+
+PerfMonitor::StageStats PerfMonitor::_stats[StageCount];
+PerfMonitor::Stage PerfMonitor::_worstStage = StageLoop;
+uint32_t PerfMonitor::_worstMicros = 0;
+unsigned long PerfMonitor::_worstMillis = 0;
+
+void PerfMonitor::record(Stage stage, uint32_t micros)
+{
+  StageStats &stats = _stats[stage];
+
+  if (!stats.count || micros < stats.minMicros)
+    stats.minMicros = micros;
+  if (micros > stats.maxMicros)
+    stats.maxMicros = micros;
+  stats.count++;
+  stats.totalMicros += micros;
+
+  // histogram bucket is the position of the highest bit
+  uint8_t bucket = 0;
+  while (bucket < PERF_HISTOGRAM_BUCKETS - 1 && (micros >> bucket))
+    bucket++;
+  stats.histogram[bucket]++;
+
+  // worst stall is tracked on detailed stages only (loop always includes them)
+  if (stage != StageLoop && stage != StageCustomApp && micros > _worstMicros)
+  {
+    _worstMicros = micros;
+    _worstStage = stage;
+    _worstMillis = millis();
+  }
+}
+
+void PerfMonitor::reset()
+{
+  memset(_stats, 0, sizeof(_stats));
+  _worstStage = StageLoop;
+  _worstMicros = 0;
+  _worstMillis = 0;
+}
+
+String PerfMonitor::generateJSON(bool withHistogram)
+{
+  JsonDocument doc;
+  char stageName[sizeof(stageNames[0])];
+
+  for (uint8_t i = 0; i < StageCount; i++)
+  {
+    if (!_stats[i].count)
+      continue;
+
+    strcpy_P(stageName, stageNames[i]);
+    JsonObject stage = doc[F("stages")][stageName].to<JsonObject>();
+    stage[F("n")] = _stats[i].count;
+    stage[F("min")] = _stats[i].minMicros;
+    stage[F("avg")] = (uint32_t)(_stats[i].totalMicros / _stats[i].count);
+    stage[F("max")] = _stats[i].maxMicros;
+
+    if (withHistogram)
+    {
+      JsonArray histogram = stage[F("hist")].to<JsonArray>();
+      for (uint8_t j = 0; j < PERF_HISTOGRAM_BUCKETS; j++)
+        histogram.add(_stats[i].histogram[j]);
+    }
+  }
+
+  if (_worstMicros)
+  {
+    strcpy_P(stageName, stageNames[_worstStage]);
+    doc[F("worst")][F("stage")] = stageName;
+    doc[F("worst")][F("us")] = _worstMicros;
+    doc[F("worst")][F("at")] = _worstMillis;
+  }
+
+  String gs;
+  serializeJson(doc, gs);
+
+  return gs;
+}
+
+// Append stages durations in OpenMetrics text format (summary and max per stage)
+void PerfMonitor::appendMetrics(String &metrics)
+{
+  char line[128];
+  char stageName[sizeof(stageNames[0])];
+
+  metrics += F("# TYPE wpalacontrol_stage_duration_seconds summary\n");
+  for (uint8_t i = 0; i < StageCount; i++)
+  {
+    if (!_stats[i].count)
+      continue;
+
+    strcpy_P(stageName, stageNames[i]);
+    snprintf_P(line, sizeof(line), PSTR("wpalacontrol_stage_duration_seconds_count{stage=\"%s\"} %lu\n"), stageName, (unsigned long)_stats[i].count);
+    metrics += line;
+    snprintf_P(line, sizeof(line), PSTR("wpalacontrol_stage_duration_seconds_sum{stage=\"%s\"} %.6f\n"), stageName, _stats[i].totalMicros / 1000000.0);
+    metrics += line;
+  }
+
+  metrics += F("# TYPE wpalacontrol_stage_duration_max_seconds gauge\n");
+  for (uint8_t i = 0; i < StageCount; i++)
+  {
+    if (!_stats[i].count)
+      continue;
+
+    strcpy_P(stageName, stageNames[i]);
+    snprintf_P(line, sizeof(line), PSTR("wpalacontrol_stage_duration_max_seconds{stage=\"%s\"} %.6f\n"), stageName, _stats[i].maxMicros / 1000000.0);
+    metrics += line;
+  }
+}
+
+#endif
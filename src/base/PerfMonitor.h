@@ -0,0 +1,76 @@
+#ifndef PerfMonitor_h
+#define PerfMonitor_h
+
+#include "../Main.h"
+
+#if PERF_ENABLED
+
+// Number of log2 buckets of stage duration histogram (bucket i counts durations in [2^(i-1), 2^i) us, last one counts everything above)
+#define PERF_HISTOGRAM_BUCKETS 20
+
+class PerfMonitor
+{
+public:
+  typedef enum
+  {
+    StageLoop = 0,
+    StageHttp,
+    StageCustomApp,
+    StageWifi,
+    StageLog,
+    StageMqtt,
+    StageDiscovery,
+    StageUpdate,
+    StageStoveAttach,
+    StageStove,
+    StagePublish,
+    StageBusResults,
+    StageUdp,
+    StageWebSocket,
+    StageCount
+  } Stage;
+
+private:
+  typedef struct
+  {
+    uint32_t count;
+    uint64_t totalMicros;
+    uint32_t minMicros;
+    uint32_t maxMicros;
+    uint32_t histogram[PERF_HISTOGRAM_BUCKETS];
+  } StageStats;
+
+  static StageStats _stats[StageCount];
+  static Stage _worstStage;
+  static uint32_t _worstMicros;
+  static unsigned long _worstMillis;
+
+public:
+  static void record(Stage stage, uint32_t micros);
+  static void reset();
+  static String generateJSON(bool withHistogram = true);
+  static void appendMetrics(String &metrics);
+};
+
+// Measure the duration of the enclosing scope
+// (micros() is used instead of the CPU cycle counter which wraps after a few seconds and would hide long stalls)
+class PerfScope
+{
+private:
+  PerfMonitor::Stage _stage;
+  unsigned long _startMicros;
+
+public:
+  PerfScope(PerfMonitor::Stage stage) : _stage(stage), _startMicros(micros()) {};
+  ~PerfScope() { PerfMonitor::record(_stage, micros() - _startMicros); };
+};
+
+#define PERF_CONCAT_(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_(a, b)
+#define PERF_SCOPE(stage) PerfScope PERF_CONCAT(perfScope, __LINE__)(PerfMonitor::stage)
+
+#else
+#define PERF_SCOPE(stage)
+#endif
+
+#endif
@@ -1,4 +1,8 @@
 #include "SystemState.h"
 
 bool SystemState::shouldReboot = false;
-bool SystemState::pauseCustomApp = false;
\ No newline at end of file
+bool SystemState::pauseCustomApp = false;
+unsigned long SystemState::firstHttpResponseMillis = 0;
+unsigned long SystemState::bootPhaseMillis[BootPhaseCount] = {0};
+unsigned long SystemState::setupPhaseMillis[SetupPhaseCount] = {0};
+unsigned long SystemState::setupPhaseStartMillis = 0;
\ No newline at end of file
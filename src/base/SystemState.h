@@ -1,13 +1,63 @@
 #ifndef SystemState_h
 #define SystemState_h
 
+#include <Arduino.h>
+
 class SystemState
 {
 public:
+    typedef enum
+    {
+        BootWiFiAssociated = 0,
+        BootWiFiGotIP,
+        BootMqttConnected,
+        BootFirstPublish,
+        BootPhaseCount
+    } BootPhase;
+
+    typedef enum
+    {
+        SetupRescue = 0,
+        SetupFileSystem,
+        SetupCore,
+        SetupWiFi,
+        SetupCustom,
+        SetupWebServer,
+        SetupPhaseCount
+    } SetupPhase;
+
     // flag used to trigger a system reboot
     static bool shouldReboot;
     // flag to pause custom application Run during Firmware Update
     static bool pauseCustomApp;
+    // time (in ms since boot) of the first HTTP request answered
+    static unsigned long firstHttpResponseMillis;
+    // time (in ms since boot) when each boot phase has been reached for the first time (0 if not yet)
+    static unsigned long bootPhaseMillis[BootPhaseCount];
+    // duration (in ms) of each setup() phase
+    static unsigned long setupPhaseMillis[SetupPhaseCount];
+    static unsigned long setupPhaseStartMillis;
+
+    static void markBootPhase(BootPhase phase)
+    {
+        if (!bootPhaseMillis[phase])
+            bootPhaseMillis[phase] = millis();
+    }
+
+    // called by request handlers when they answer
+    static void markFirstHttpResponse()
+    {
+        if (!firstHttpResponseMillis)
+            firstHttpResponseMillis = millis();
+    }
+
+    // record duration of the setup phase that just ended (next one starts now)
+    static void endSetupPhase(SetupPhase phase)
+    {
+        unsigned long now = millis();
+        setupPhaseMillis[phase] = now - setupPhaseStartMillis;
+        setupPhaseStartMillis = now;
+    }
 };
 
 #endif
\ No newline at end of file
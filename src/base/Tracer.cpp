@@ -0,0 +1,85 @@
+#include "Tracer.h"
+
+#if TRACE_ENABLED
+
+Tracer::TraceEvent Tracer::_events[TRACE_BUFFER_EVENTS];
+volatile uint32_t Tracer::_head = 0;
+volatile bool Tracer::_paused = false;
+#ifndef ESP8266
+portMUX_TYPE Tracer::_mux = portMUX_INITIALIZER_UNLOCKED;
+#endif
+
+void Tracer::record(const char *name, char phase)
+{
+  // buffer is frozen while it is exported
+  if (_paused)
+    return;
+
+#ifndef ESP8266
+  portENTER_CRITICAL(&_mux);
+#endif
+
+  TraceEvent &event = _events[_head % TRACE_BUFFER_EVENTS];
+  event.name = name;
+  event.micros = micros();
+  event.phase = phase;
+#ifdef ESP8266
+  event.tid = 0;
+#else
+  event.tid = xPortGetCoreID();
+#endif
+  _head = _head + 1;
+
+#ifndef ESP8266
+  portEXIT_CRITICAL(&_mux);
+#endif
+}
+
+void Tracer::streamJSON(WebServer &server)
+{
+  char chunk[512];
+  size_t chunkLength = 0;
+  char name[32];
+
+  // freeze buffer during export
+  _paused = true;
+
+  uint32_t head = _head;
+  uint32_t pos = (head > TRACE_BUFFER_EVENTS) ? head - TRACE_BUFFER_EVENTS : 0;
+  bool first = true;
+
+  server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server.send(200, F("application/json"), "");
+  server.sendContent_P(PSTR("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+
+  for (; pos != head; pos++)
+  {
+    const TraceEvent &event = _events[pos % TRACE_BUFFER_EVENTS];
+
+    strncpy_P(name, event.name, sizeof(name) - 1);
+    name[sizeof(name) - 1] = 0;
+
+    // send chunk if next event may not fit
+    if (chunkLength > sizeof(chunk) - 128)
+    {
+      server.sendContent(chunk, chunkLength);
+      chunkLength = 0;
+    }
+
+    chunkLength += snprintf_P(chunk + chunkLength, sizeof(chunk) - chunkLength,
+                              PSTR("%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lu,\"pid\":1,\"tid\":%u%s}"),
+                              first ? "" : ",", name, event.phase, (unsigned long)event.micros, event.tid,
+                              event.phase == 'i' ? ",\"s\":\"t\"" : "");
+    first = false;
+  }
+
+  if (chunkLength)
+    server.sendContent(chunk, chunkLength);
+
+  _paused = false;
+
+  server.sendContent_P(PSTR("]}"));
+  server.sendContent(emptyString);
+}
+
+#endif
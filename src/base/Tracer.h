@@ -0,0 +1,60 @@
+#ifndef Tracer_h
+#define Tracer_h
+
+#include "../Main.h"
+
+#if TRACE_ENABLED
+
+#ifdef ESP8266
+#include <ESP8266WebServer.h>
+using WebServer = ESP8266WebServer;
+#else
+#include <WebServer.h>
+#endif
+
+// Records begin/end events in a RAM ring buffer and exports them as Chrome trace_event JSON
+// (open the downloaded file in chrome://tracing or https://ui.perfetto.dev)
+class Tracer
+{
+private:
+  typedef struct
+  {
+    const char *name; // PROGMEM string
+    uint32_t micros;
+    char phase; // 'B'egin, 'E'nd or 'i'nstant
+    uint8_t tid;
+  } TraceEvent;
+
+  static TraceEvent _events[TRACE_BUFFER_EVENTS];
+  static volatile uint32_t _head; // total number of events recorded since boot
+  static volatile bool _paused;
+#ifndef ESP8266
+  static portMUX_TYPE _mux;
+#endif
+
+public:
+  static void record(const char *name, char phase);
+  static void streamJSON(WebServer &server);
+};
+
+class TraceScope
+{
+private:
+  const char *_name;
+
+public:
+  TraceScope(const char *name) : _name(name) { Tracer::record(_name, 'B'); };
+  ~TraceScope() { Tracer::record(_name, 'E'); };
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(PSTR(name))
+#define TRACE_INSTANT(name) Tracer::record(PSTR(name), 'i')
+
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_INSTANT(name)
+#endif
+
+#endif
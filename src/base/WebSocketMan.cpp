@@ -0,0 +1,92 @@
+#include "WebSocketMan.h"
+
+#if WS_ENABLED
+
+void WebSocketMan::webSocketEvent(uint8_t clientNum, WStype_t type, uint8_t *payload, size_t length)
+{
+    // a new connection (or none) now uses this client slot
+    if (type == WStype_CONNECTED || type == WStype_DISCONNECTED)
+        _sessions.changed(clientNum);
+
+    switch (type)
+    {
+    case WStype_CONNECTED:
+#if DEVELOPPER_MODE
+        LOG_SERIAL_PRINTF_P(PSTR("webSocketEvent - client #%d (%s) connected\n"), clientNum, _webSocketServer.remoteIP(clientNum).toString().c_str());
+#endif
+        break;
+
+    case WStype_DISCONNECTED:
+#if DEVELOPPER_MODE
+        LOG_SERIAL_PRINTF_P(PSTR("webSocketEvent - client #%d disconnected\n"), clientNum);
+#endif
+        break;
+
+    case WStype_TEXT:
+        // text frames are commands
+        if (_commandCallback)
+            _commandCallback(clientNum, (const char *)payload, length);
+        break;
+
+    default:
+        break;
+    }
+}
+
+void WebSocketMan::begin(CommandCallback commandCallback)
+{
+    _commandCallback = commandCallback;
+
+    _webSocketServer.onEvent([this](uint8_t clientNum, WStype_t type, uint8_t *payload, size_t length)
+                             { webSocketEvent(clientNum, type, payload, length); });
+    _webSocketServer.enableHeartbeat(WS_PING_INTERVAL, WS_PONG_TIMEOUT, WS_DISCONNECT_TIMEOUT_COUNT);
+    _webSocketServer.begin();
+}
+
+// same events as EventSourceMan, message is expected to be JSON : {"event":"<eventType>","data":<message>}
+void WebSocketMan::broadcast(const String &message, const String &eventType) // default eventType is "message"
+{
+    if (!_webSocketServer.connectedClients())
+        return;
+
+    String frame;
+    frame.reserve(message.length() + eventType.length() + 22);
+    frame = F("{\"event\":\"");
+    frame += eventType;
+    frame += F("\",\"data\":");
+    frame += message;
+    frame += '}';
+
+    _webSocketServer.broadcastTXT(frame);
+}
+
+void WebSocketMan::sendTo(uint8_t clientNum, const String &message)
+{
+    _webSocketServer.sendTXT(clientNum, message.c_str(), message.length());
+}
+
+WsSession WebSocketMan::session(uint8_t clientNum)
+{
+    return _sessions.session(clientNum);
+}
+
+bool WebSocketMan::sendTo(const WsSession &session, const String &message)
+{
+    if (!_sessions.isCurrent(session))
+        return false;
+
+    sendTo(session.clientNum, message);
+    return true;
+}
+
+uint8_t WebSocketMan::connectedClients()
+{
+    return _webSocketServer.connectedClients();
+}
+
+void WebSocketMan::run()
+{
+    _webSocketServer.loop();
+}
+
+#endif // WS_ENABLED
@@ -0,0 +1,42 @@
+#ifndef WebSocketMan_h
+#define WebSocketMan_h
+
+#include "../Main.h"
+
+#if WS_ENABLED
+
+#include <WebSocketsServer.h>
+#include "../WsSessions.h"
+
+// heartbeat used to detect dead clients (ping interval, pong timeout in ms and missed pongs before disconnect)
+#define WS_PING_INTERVAL 15000
+#define WS_PONG_TIMEOUT 3000
+#define WS_DISCONNECT_TIMEOUT_COUNT 2
+
+class WebSocketMan
+{
+public:
+    typedef std::function<void(uint8_t clientNum, const char *payload, size_t length)> CommandCallback;
+
+private:
+    WebSocketsServer _webSocketServer{WS_PORT};
+    CommandCallback _commandCallback = nullptr;
+    WsSessions<WEBSOCKETS_SERVER_CLIENT_MAX> _sessions;
+
+    void webSocketEvent(uint8_t clientNum, WStype_t type, uint8_t *payload, size_t length);
+
+public:
+    void begin(CommandCallback commandCallback);
+    void broadcast(const String &message, const String &eventType = "message");
+    void sendTo(uint8_t clientNum, const String &message);
+    // identify the connection using a client slot : answers computed for a previous connection are dropped
+    WsSession session(uint8_t clientNum);
+    // send message only if the client slot is still used by the same connection
+    bool sendTo(const WsSession &session, const String &message);
+    uint8_t connectedClients();
+    void run();
+};
+
+#endif // WS_ENABLED
+
+#endif
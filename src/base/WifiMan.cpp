@@ -19,52 +19,46 @@ void WifiMan::enableAP(bool force = false)
 
 void WifiMan::refreshWiFi()
 {
+  // a connection attempt is already running
+  if (_wifiConnecting)
+    return;
+
   if (ssid[0]) // if STA configured
   {
     if (!WiFi.isConnected() || WiFi.SSID() != ssid || WiFi.psk() != password)
     {
       enableAP();
 
-      LOG_SERIAL_PRINT(F("Connect"));
-
-      WiFi.begin(ssid, password);
-      WiFi.config(ip, gw, mask, dns1, dns2);
-
-      // Wait _reconnectDuration for connection
-      for (int i = 0; i < (((uint16_t)_reconnectDuration) * 10) && !WiFi.isConnected(); i++)
-      {
-        if ((i % 10) == 0)
-          LOG_SERIAL_PRINT(".");
-        delay(100);
-      }
+      // if last connection is known, connect directly to the same AP/channel
+      _fastConnecting = _fastConnectCacheValid;
+      _leaseFromCache = false;
 
-      // if connection is successfull
-      if (WiFi.isConnected())
+      if (_fastConnecting)
       {
-        // stop DNS server
-        _dnsServer->stop();
-        delete _dnsServer;
-        _dnsServer = nullptr;
-        // disable AP
-        WiFi.enableAP(false);
-#ifdef STATUS_LED_GOOD
-        STATUS_LED_GOOD
+        LOG_SERIAL_PRINT(F("Fast connect"));
+
+        WiFi.begin(ssid, password, _fastConnectCache.channel, _fastConnectCache.bssid);
+#if WIFI_FAST_CONNECT_CACHED_LEASE
+        if (!ip && _fastConnectCache.ip)
+        {
+          WiFi.config(_fastConnectCache.ip, _fastConnectCache.gw, _fastConnectCache.mask, _fastConnectCache.dns1, _fastConnectCache.dns2);
+          _leaseFromCache = true;
+        }
+        else
 #endif
-
-        LOG_SERIAL_PRINTF_P(PSTR("Connected (%s) "), WiFi.localIP().toString().c_str());
+          WiFi.config(ip, gw, mask, dns1, dns2);
       }
-      else // connection failed
+      else
       {
-        WiFi.disconnect();
-        LOG_SERIAL_PRINT(F("AP not found "));
-#ifdef ESP8266
-        _refreshTicker.once(_refreshPeriod, [this]()
-                            { _needRefreshWifi = true; });
-#else
-        _refreshTicker.once<typeof this>(_refreshPeriod * 1000, [](typeof this wifiMan)
-                                         { wifiMan->_needRefreshWifi = true; }, this);
-#endif
+        LOG_SERIAL_PRINT(F("Connect"));
+
+        WiFi.begin(ssid, password);
+        WiFi.config(ip, gw, mask, dns1, dns2);
       }
+
+      // connection result is checked by appRun for _reconnectDuration
+      _wifiConnecting = true;
+      _wifiConnectStartMillis = millis();
     }
   }
   else // else if AP is configured
@@ -78,6 +72,142 @@ void WifiMan::refreshWiFi()
 
     LOG_SERIAL_PRINTF_P(PSTR(" AP mode(%s - %s) "), F(DEFAULT_AP_SSID), WiFi.softAPIP().toString().c_str());
   }
+
+  // right config so no need to touch again flash
+  WiFi.persistent(false);
+}
+
+void WifiMan::checkWiFiConnection()
+{
+  // if connection is successfull
+  if (WiFi.isConnected())
+  {
+    _wifiConnecting = false;
+
+    // stop DNS server
+    if (_dnsServer)
+    {
+      _dnsServer->stop();
+      delete _dnsServer;
+      _dnsServer = nullptr;
+    }
+    // disable AP
+    WiFi.enableAP(false);
+#ifdef STATUS_LED_GOOD
+    STATUS_LED_GOOD
+#endif
+
+    LOG_SERIAL_PRINTF_P(PSTR("Connected (%s)\n"), WiFi.localIP().toString().c_str());
+
+    // keep this connection for next fast reconnect
+    // (an IP coming from the cache was not delivered by the DHCP server, so it must not refresh the cached lease)
+    if (!_leaseFromCache)
+      saveFastConnectCache();
+  }
+  else if (_fastConnecting && millis() - _wifiConnectStartMillis >= ((unsigned long)_fastConnectDuration) * 1000UL) // fast connection failed
+  {
+    _wifiConnecting = false;
+
+    // AP moved or lease is not valid anymore, forget it and fallback to full connection
+    LOG_SERIAL_PRINTLN(F("Fast connect failed"));
+    WiFi.disconnect();
+    _fastConnectCacheValid = false;
+    LittleFS.remove(String(F("/WiFiCache.bin")));
+    refreshWiFi();
+  }
+  else if (millis() - _wifiConnectStartMillis >= ((unsigned long)_reconnectDuration) * 1000UL) // connection failed
+  {
+    _wifiConnecting = false;
+
+    WiFi.disconnect();
+    LOG_SERIAL_PRINTLN(F("AP not found"));
+#ifdef ESP8266
+    _refreshTicker.once(_refreshPeriod, [this]()
+                        { _needRefreshWifi = true; });
+#else
+    _refreshTicker.once<typeof this>(_refreshPeriod * 1000, [](typeof this wifiMan)
+                                     { wifiMan->_needRefreshWifi = true; }, this);
+#endif
+  }
+}
+
+void WifiMan::loadFastConnectCache()
+{
+  _fastConnectCacheValid = false;
+
+  File cacheFile = LittleFS.open(String(F("/WiFiCache.bin")), "r");
+  if (!cacheFile)
+    return;
+
+  // cache is valid only if it has the right format and belongs to configured network
+  _fastConnectCacheValid = (cacheFile.read((uint8_t *)&_fastConnectCache, sizeof(_fastConnectCache)) == sizeof(_fastConnectCache) &&
+                            _fastConnectCache.version == sizeof(FastConnectCache) &&
+                            ssid[0] && !strcmp(_fastConnectCache.ssid, ssid));
+  cacheFile.close();
+}
+
+void WifiMan::saveFastConnectCache()
+{
+  FastConnectCache newCache;
+  memset(&newCache, 0, sizeof(newCache));
+
+  newCache.version = sizeof(FastConnectCache);
+  strlcpy(newCache.ssid, ssid, sizeof(newCache.ssid));
+  memcpy(newCache.bssid, WiFi.BSSID(), sizeof(newCache.bssid));
+  newCache.channel = WiFi.channel();
+  newCache.ip = static_cast<uint32_t>(WiFi.localIP());
+  newCache.gw = static_cast<uint32_t>(WiFi.gatewayIP());
+  newCache.mask = static_cast<uint32_t>(WiFi.subnetMask());
+  newCache.dns1 = static_cast<uint32_t>(WiFi.dnsIP(0));
+  newCache.dns2 = static_cast<uint32_t>(WiFi.dnsIP(1));
+
+  // write flash only if something changed
+  if (_fastConnectCacheValid && !memcmp(&newCache, &_fastConnectCache, sizeof(newCache)))
+    return;
+
+  File cacheFile = LittleFS.open(String(F("/WiFiCache.bin")), "w");
+  if (!cacheFile)
+    return;
+
+  cacheFile.write((const uint8_t *)&newCache, sizeof(newCache));
+  cacheFile.close();
+
+  _fastConnectCache = newCache;
+  _fastConnectCacheValid = true;
+}
+
+void WifiMan::selectAPChannel()
+{
+  int n = WiFi.scanComplete();
+
+  // scan still running
+  if (n == -1)
+    return;
+
+  _apChannelScanPending = false;
+
+  // search for best free channel
+  if (n > 0)
+  {
+    while (_apChannel < 12)
+    {
+      int i = 0;
+      while (i < n && WiFi.channel(i) != _apChannel)
+        i++;
+      if (i == n)
+        break;
+      _apChannel++;
+    }
+  }
+
+  // scan results are not needed anymore (-2 means results were already used by /wnl)
+  if (n >= 0)
+    WiFi.scanDelete();
+
+  LOG_SERIAL_PRINTF_P(PSTR("WiFi : %dN-CH%d "), n, _apChannel);
+
+  // Call RefreshWiFi to initiate configuration
+  refreshWiFi();
 }
 
 void WifiMan::setConfigDefaultValues()
@@ -192,6 +322,34 @@ String WifiMan::generateConfigJSON(bool forSaveFile = false)
   return gc;
 }
 
+void WifiMan::writeConfigRecord(void *record)
+{
+  ConfigRecord *configRecord = (ConfigRecord *)record;
+
+  memcpy(configRecord->ssid, ssid, sizeof(ssid));
+  memcpy(configRecord->password, password, sizeof(password));
+  memcpy(configRecord->hostname, hostname, sizeof(hostname));
+  configRecord->ip = ip;
+  configRecord->gw = gw;
+  configRecord->mask = mask;
+  configRecord->dns1 = dns1;
+  configRecord->dns2 = dns2;
+}
+
+void WifiMan::readConfigRecord(const void *record)
+{
+  const ConfigRecord *configRecord = (const ConfigRecord *)record;
+
+  memcpy(ssid, configRecord->ssid, sizeof(ssid));
+  memcpy(password, configRecord->password, sizeof(password));
+  memcpy(hostname, configRecord->hostname, sizeof(hostname));
+  ip = configRecord->ip;
+  gw = configRecord->gw;
+  mask = configRecord->mask;
+  dns1 = configRecord->dns1;
+  dns2 = configRecord->dns2;
+}
+
 String WifiMan::generateStatusJSON()
 {
   JsonDocument doc;
@@ -210,7 +368,7 @@ String WifiMan::generateStatusJSON()
     if (WiFi.isConnected())
     {
       doc[F("stationip")] = WiFi.localIP().toString();
-      doc[F("stationipsource")] = ip ? F("Static IP") : F("DHCP");
+      doc[F("stationipsource")] = ip ? F("Static IP") : (_leaseFromCache ? F("Cached DHCP lease") : F("DHCP"));
     }
   }
   else
@@ -218,6 +376,16 @@ String WifiMan::generateStatusJSON()
 
   doc[F("mac")] = WiFi.macAddress();
 
+  // boot phases timing (in ms since boot)
+  if (SystemState::bootPhaseMillis[SystemState::BootWiFiAssociated])
+    doc[F("bootassociated")] = SystemState::bootPhaseMillis[SystemState::BootWiFiAssociated];
+  if (SystemState::bootPhaseMillis[SystemState::BootWiFiGotIP])
+    doc[F("bootgotip")] = SystemState::bootPhaseMillis[SystemState::BootWiFiGotIP];
+  if (SystemState::bootPhaseMillis[SystemState::BootMqttConnected])
+    doc[F("bootmqttup")] = SystemState::bootPhaseMillis[SystemState::BootMqttConnected];
+  if (SystemState::bootPhaseMillis[SystemState::BootFirstPublish])
+    doc[F("bootfirstpublish")] = SystemState::bootPhaseMillis[SystemState::BootFirstPublish];
+
   String gs;
   serializeJson(doc, gs);
 
@@ -235,28 +403,30 @@ bool WifiMan::appInit(bool reInit = false)
 
   // Stop RefreshWiFi and disconnect before WiFi operations -----
   _refreshTicker.detach();
+  _wifiConnecting = false;
   WiFi.disconnect();
 
-  // scan networks to search for best free channel
-  int n = WiFi.scanNetworks();
+  // Set hostname (before any connection so DHCP uses it)
+  WiFi.hostname(hostname);
 
-  LOG_SERIAL_PRINTF_P(PSTR("%dN-CH"), n);
+  // load last successful connection for fast reconnect
+  loadFastConnectCache();
 
-  if (n)
+#if FAST_BOOT
+  // known network : connect right away, AP stays on default channel
+  if (_fastConnectCacheValid)
   {
-    while (_apChannel < 12)
-    {
-      int i = 0;
-      while (i < n && WiFi.channel(i) != _apChannel)
-        i++;
-      if (i == n)
-        break;
-      _apChannel++;
-    }
+    _apChannelScanPending = false;
+    refreshWiFi();
+  }
+  else
+#endif
+  {
+    // scan networks in background to search for best free channel
+    // (connection is started by appRun once the scan is complete)
+    WiFi.scanNetworks(true);
+    _apChannelScanPending = true;
   }
-
-  LOG_SERIAL_PRINT(_apChannel);
-  LOG_SERIAL_PRINT(' ');
 
   // Configure handlers
   if (!reInit)
@@ -314,21 +484,37 @@ bool WifiMan::appInit(bool reInit = false)
                                                                    WiFiEvent_t::ARDUINO_EVENT_WIFI_AP_STADISCONNECTED
 #endif
     );
-  }
 
-  // Set hostname
-  WiFi.hostname(hostname);
-
-  // Call RefreshWiFi to initiate configuration
-  refreshWiFi();
+    // boot phases timing : station associated then IP obtained
+#ifdef ESP8266
+    _associatedHandler = WiFi.onStationModeConnected([](const WiFiEventStationModeConnected &evt)
+#else
+    WiFi.onEvent([](WiFiEvent_t event, WiFiEventInfo_t info)
+#endif
+                                                     { SystemState::markBootPhase(SystemState::BootWiFiAssociated); }
+#ifndef ESP8266
+                                                     ,
+                                                     WiFiEvent_t::ARDUINO_EVENT_WIFI_STA_CONNECTED
+#endif
+    );
 
-  // right config so no need to touch again flash
-  WiFi.persistent(false);
+#ifdef ESP8266
+    _gotIPHandler = WiFi.onStationModeGotIP([](const WiFiEventStationModeGotIP &evt)
+#else
+    WiFi.onEvent([](WiFiEvent_t event, WiFiEventInfo_t info)
+#endif
+                                            { SystemState::markBootPhase(SystemState::BootWiFiGotIP); }
+#ifndef ESP8266
+                                            ,
+                                            WiFiEvent_t::ARDUINO_EVENT_WIFI_STA_GOT_IP
+#endif
+    );
+  }
 
   // start MDNS
   MDNS.begin(CUSTOM_APP_MODEL);
 
-  return (ssid[0] ? WiFi.isConnected() : true);
+  return true;
 }
 
 const PROGMEM char *WifiMan::getHTMLContent(WebPageForPlaceHolder wp)
@@ -405,6 +591,14 @@ void WifiMan::appInitWebServer(WebServer &server)
 
 void WifiMan::appRun()
 {
+  // when channel scan is complete, select AP channel then start connection
+  if (_apChannelScanPending)
+    selectAPChannel();
+
+  // check connection progress
+  if (_wifiConnecting)
+    checkWiFiConnection();
+
   // if refreshWifi is required and no client is connected to the softAP
   if (_needRefreshWifi && !_stationConnectedToSoftAP)
   {
@@ -31,14 +31,51 @@ private:
   uint32_t dns1 = 0;
   uint32_t dns2 = 0;
 
+  // Binary config record (same content as WiFi.json)
+  typedef struct
+  {
+    char ssid[32 + 1];
+    char password[64 + 1];
+    char hostname[24 + 1];
+    uint32_t ip;
+    uint32_t gw;
+    uint32_t mask;
+    uint32_t dns1;
+    uint32_t dns2;
+  } ConfigRecord;
+
+  // Last successful connection (used for fast reconnect)
+  typedef struct
+  {
+    uint16_t version;
+    char ssid[32 + 1];
+    uint8_t bssid[6];
+    int32_t channel;
+    uint32_t ip;
+    uint32_t gw;
+    uint32_t mask;
+    uint32_t dns1;
+    uint32_t dns2;
+  } FastConnectCache;
+
 // Run properties
 #ifdef ESP8266
   WiFiEventHandler _discoEventHandler;
   WiFiEventHandler _staConnectedHandler;
   WiFiEventHandler _staDisconnectedHandler;
+  WiFiEventHandler _associatedHandler;
+  WiFiEventHandler _gotIPHandler;
 #endif
+  FastConnectCache _fastConnectCache;
+  bool _fastConnectCacheValid = false;
+  bool _fastConnecting = false;
+  bool _leaseFromCache = false; // current IP is the cached DHCP lease (WIFI_FAST_CONNECT_CACHED_LEASE)
+  uint8_t _fastConnectDuration = 5; // duration to try fast connection before falling back to full connection in seconds
   DNSServer *_dnsServer = nullptr;
   int _apChannel = 2;
+  bool _apChannelScanPending = false;
+  bool _wifiConnecting = false;
+  unsigned long _wifiConnectStartMillis = 0;
   bool _needRefreshWifi = false;
   bool _stationConnectedToSoftAP = false;
   Ticker _refreshTicker;
@@ -47,10 +84,18 @@ private:
 
   void enableAP(bool force);
   void refreshWiFi();
+  void checkWiFiConnection();
+  void loadFastConnectCache();
+  void saveFastConnectCache();
+  void selectAPChannel();
 
   void setConfigDefaultValues();
   bool parseConfigJSON(JsonDocument &doc, bool fromWebPage);
   String generateConfigJSON(bool forSaveFile);
+  uint16_t getConfigRecordVersion() { return 1; }; // to increase when ConfigRecord layout changes (JSON config is used meanwhile)
+  size_t getConfigRecordSize() { return sizeof(ConfigRecord); };
+  void writeConfigRecord(void *record);
+  void readConfigRecord(const void *record);
   String generateStatusJSON();
   bool appInit(bool reInit);
   const PROGMEM char *getHTMLContent(WebPageForPlaceHolder wp);
@@ -0,0 +1,160 @@
+// Stove memory dump against a simulated memory map (pio test -e native)
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "AdrrDump.h"
+
+#define READ_INTERVAL 10 // ms between two reads (same as ADRR_READ_INTERVAL)
+#define READ_DURATION 3  // simulated bus transaction time (in ms)
+
+static uint16_t memoryMap[0x10000];
+static unsigned long nowMillis;
+static unsigned long lastReadMillis;
+static unsigned long minReadGap;
+static uint32_t reads;
+static int32_t failAddress;
+
+void setUp(void)
+{
+  for (uint32_t address = 0; address < 0x10000; address++)
+    memoryMap[address] = (uint16_t)(address * 2654435761u >> 16);
+
+  nowMillis = 100000;
+  lastReadMillis = 0;
+  minReadGap = (unsigned long)-1;
+  reads = 0;
+  failAddress = -1;
+}
+void tearDown(void) {}
+
+static bool simulatedRead(uint16_t address, uint16_t &value)
+{
+  if (reads && nowMillis - lastReadMillis < minReadGap)
+    minReadGap = nowMillis - lastReadMillis;
+  lastReadMillis = nowMillis;
+  reads++;
+
+  nowMillis += READ_DURATION;
+  if (address == failAddress)
+    return false;
+
+  value = memoryMap[address];
+  return true;
+}
+
+// run the dump like the stove bus does : one step per run, sleeping until next read is allowed
+static unsigned long runDump(AdrrDump &dump)
+{
+  unsigned long start = nowMillis;
+  uint32_t steps = 0;
+
+  while (!dump.step(nowMillis, simulatedRead))
+  {
+    unsigned long wait = dump.nextReadDelay(nowMillis);
+    nowMillis += wait ? wait : 1;
+    TEST_ASSERT_TRUE(++steps < 100000);
+  }
+
+  return nowMillis - start;
+}
+
+void test_bin_dump_matches_memory(void)
+{
+  AdrrDump dump(0x2000, 0x100, 0, false, READ_INTERVAL);
+  runDump(dump);
+
+  TEST_ASSERT_TRUE(dump.done());
+  TEST_ASSERT_FALSE(dump.failed());
+  TEST_ASSERT_EQUAL_UINT32(0x100 * 2, dump.outputLength());
+
+  const uint8_t *output = (const uint8_t *)dump.output();
+  for (uint32_t i = 0; i < 0x100; i++)
+    TEST_ASSERT_EQUAL_UINT16(memoryMap[0x2000 + i], (uint16_t)(output[2 * i] | output[2 * i + 1] << 8));
+}
+
+void test_hex_dump_format(void)
+{
+  for (uint16_t i = 0; i < 10; i++)
+    memoryMap[0x1ffc + i] = 0x0100 * i + 0xff;
+
+  AdrrDump dump(0x1ffc, 10, 0, true, READ_INTERVAL);
+  runDump(dump);
+
+  const char expected[] = "1ffc: 00ff 01ff 02ff 03ff 04ff 05ff 06ff 07ff\r\n"
+                          "2004: 08ff 09ff\r\n";
+  TEST_ASSERT_EQUAL_UINT32(strlen(expected), dump.outputLength());
+  TEST_ASSERT_EQUAL_MEMORY(expected, dump.output(), strlen(expected));
+}
+
+void test_hex_dump_fills_its_buffer(void)
+{
+  // biggest dump : every line is complete
+  AdrrDump dump(0xff00, 0x100, 0, true, READ_INTERVAL);
+  runDump(dump);
+
+  TEST_ASSERT_FALSE(dump.failed());
+  TEST_ASSERT_EQUAL_UINT32(0x100 / 8 * ADRR_DUMP_HEX_LINE_LENGTH, dump.outputLength());
+  TEST_ASSERT_EQUAL_MEMORY("fff8:", dump.output() + dump.outputLength() - ADRR_DUMP_HEX_LINE_LENGTH, 5);
+}
+
+void test_reads_are_paced(void)
+{
+  AdrrDump dump(0, 0x100, 0, false, READ_INTERVAL);
+  unsigned long duration = runDump(dump);
+
+  // one read per address, never closer than the read interval, without extra waiting
+  TEST_ASSERT_EQUAL_UINT32(0x100, reads);
+  TEST_ASSERT_EQUAL_UINT32(READ_INTERVAL, minReadGap);
+  TEST_ASSERT_EQUAL_UINT32((0x100 - 1) * READ_INTERVAL + READ_DURATION, duration);
+
+  char message[64];
+  snprintf(message, sizeof(message), "throughput: %lu addresses/s", 0x100 * 1000UL / duration);
+  TEST_MESSAGE(message);
+}
+
+void test_step_too_early_does_not_read(void)
+{
+  AdrrDump dump(0x100, 2, 0, false, READ_INTERVAL);
+
+  TEST_ASSERT_FALSE(dump.step(nowMillis, simulatedRead));
+  TEST_ASSERT_EQUAL_UINT32(1, reads);
+
+  // interval not elapsed yet
+  TEST_ASSERT_FALSE(dump.step(nowMillis, simulatedRead));
+  TEST_ASSERT_EQUAL_UINT32(1, reads);
+  TEST_ASSERT_EQUAL_UINT32(READ_INTERVAL - READ_DURATION, dump.nextReadDelay(nowMillis));
+
+  nowMillis += dump.nextReadDelay(nowMillis);
+  TEST_ASSERT_TRUE(dump.step(nowMillis, simulatedRead));
+  TEST_ASSERT_EQUAL_UINT32(2, reads);
+}
+
+void test_failure_stops_dump(void)
+{
+  failAddress = 0x3005;
+
+  AdrrDump dump(0x3000, 0x20, 0, false, READ_INTERVAL);
+  runDump(dump);
+
+  TEST_ASSERT_TRUE(dump.done());
+  TEST_ASSERT_TRUE(dump.failed());
+  TEST_ASSERT_EQUAL_UINT16(5, dump.addressesRead());
+  TEST_ASSERT_EQUAL_UINT32(6, reads);
+
+  // no more read once failed
+  nowMillis += READ_INTERVAL;
+  TEST_ASSERT_TRUE(dump.step(nowMillis, simulatedRead));
+  TEST_ASSERT_EQUAL_UINT32(6, reads);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_bin_dump_matches_memory);
+  RUN_TEST(test_hex_dump_format);
+  RUN_TEST(test_hex_dump_fills_its_buffer);
+  RUN_TEST(test_reads_are_paced);
+  RUN_TEST(test_step_too_early_does_not_read);
+  RUN_TEST(test_failure_stops_dump);
+  return UNITY_END();
+}
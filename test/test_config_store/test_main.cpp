@@ -0,0 +1,225 @@
+// Config store round trip, corruption and power cut at every step of a save (pio test -e native)
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "ConfigStore.h"
+
+typedef struct
+{
+  char hostname[24];
+  uint16_t port;
+  uint8_t flags;
+} Record;
+
+// in-memory file system, power is cut after a given number of operations (partial write for the cut one)
+class MemoryFS : public ConfigFS
+{
+public:
+  std::map<std::string, std::vector<uint8_t>> files;
+  int operationsLeft = -1; // -1 : no power cut
+
+  bool powered()
+  {
+    if (operationsLeft < 0)
+      return true;
+    if (!operationsLeft)
+      return false;
+    operationsLeft--;
+    return true;
+  }
+
+  long fileSize(const char *path) override
+  {
+    auto file = files.find(path);
+    return file == files.end() ? -1 : (long)file->second.size();
+  }
+
+  long readFile(const char *path, uint8_t *buffer, size_t size) override
+  {
+    auto file = files.find(path);
+    if (file == files.end())
+      return -1;
+    size_t length = file->second.size() < size ? file->second.size() : size;
+    memcpy(buffer, file->second.data(), length);
+    return length;
+  }
+
+  bool writeFile(const char *path, const uint8_t *data, size_t length) override
+  {
+    if (operationsLeft == 0)
+      return false;
+    // power cut during this write : file is truncated
+    if (operationsLeft == 1)
+    {
+      files[path].assign(data, data + length / 2);
+      operationsLeft = 0;
+      return false;
+    }
+    powered();
+    files[path].assign(data, data + length);
+    return true;
+  }
+
+  bool rename(const char *from, const char *to) override
+  {
+    if (!powered() || !files.count(from))
+      return false;
+    files[to] = files[from];
+    files.erase(from);
+    return true;
+  }
+
+  bool remove(const char *path) override
+  {
+    if (!powered())
+      return false;
+    return files.erase(path) > 0;
+  }
+};
+
+static MemoryFS fs;
+
+static const char *jsonA = "{\"hostname\":\"wpalacontrol\",\"port\":1883}";
+static const char *jsonB = "{\"hostname\":\"stove-living-room\",\"port\":8883}";
+static const Record recordA = {"wpalacontrol", 1883, 1};
+static const Record recordB = {"stove-living-room", 8883, 3};
+
+static ConfigStore store()
+{
+  return ConfigStore(fs, "/WPalaControl", 1, sizeof(Record));
+}
+
+void setUp(void)
+{
+  fs.files.clear();
+  fs.operationsLeft = -1;
+}
+void tearDown(void) {}
+
+void test_round_trip(void)
+{
+  ConfigStore configStore = store();
+  TEST_ASSERT_TRUE(configStore.save(jsonA, strlen(jsonA), (const uint8_t *)&recordA));
+
+  Record loaded;
+  TEST_ASSERT_EQUAL(ConfigStore::LoadRecord, configStore.load((uint8_t *)&loaded));
+  TEST_ASSERT_EQUAL_MEMORY(&recordA, &loaded, sizeof(Record));
+
+  // only final files are left
+  TEST_ASSERT_EQUAL(2, (int)fs.files.size());
+  TEST_ASSERT_TRUE(fs.files.count("/WPalaControl.json") && fs.files.count("/WPalaControl.bin"));
+}
+
+void test_no_config(void)
+{
+  Record loaded;
+  TEST_ASSERT_EQUAL(ConfigStore::LoadNone, store().load((uint8_t *)&loaded));
+}
+
+void test_legacy_json_migration(void)
+{
+  // previous firmware left a JSON file only
+  fs.files["/WPalaControl.json"].assign(jsonA, jsonA + strlen(jsonA));
+
+  Record loaded;
+  TEST_ASSERT_EQUAL(ConfigStore::LoadJson, store().load((uint8_t *)&loaded));
+}
+
+void test_json_changed_after_rollback(void)
+{
+  ConfigStore configStore = store();
+  TEST_ASSERT_TRUE(configStore.save(jsonA, strlen(jsonA), (const uint8_t *)&recordA));
+
+  // older firmware (JSON only) saved a new config, record is now outdated
+  fs.files["/WPalaControl.json"].assign(jsonB, jsonB + strlen(jsonB));
+
+  Record loaded;
+  TEST_ASSERT_EQUAL(ConfigStore::LoadJson, configStore.load((uint8_t *)&loaded));
+}
+
+void test_corrupted_record(void)
+{
+  ConfigStore configStore = store();
+  TEST_ASSERT_TRUE(configStore.save(jsonA, strlen(jsonA), (const uint8_t *)&recordA));
+  Record loaded;
+
+  // flipped bit in the record
+  fs.files["/WPalaControl.bin"][sizeof(ConfigStore::RecordHeader) + 3] ^= 0x10;
+  TEST_ASSERT_EQUAL(ConfigStore::LoadJson, configStore.load((uint8_t *)&loaded));
+
+  // truncated record
+  TEST_ASSERT_TRUE(configStore.save(jsonA, strlen(jsonA), (const uint8_t *)&recordA));
+  fs.files["/WPalaControl.bin"].pop_back();
+  TEST_ASSERT_EQUAL(ConfigStore::LoadJson, configStore.load((uint8_t *)&loaded));
+
+  // record of another format version
+  TEST_ASSERT_TRUE(configStore.save(jsonA, strlen(jsonA), (const uint8_t *)&recordA));
+  ConfigStore otherVersion(fs, "/WPalaControl", 2, sizeof(Record));
+  TEST_ASSERT_EQUAL(ConfigStore::LoadJson, otherVersion.load((uint8_t *)&loaded));
+}
+
+void test_power_cut_during_save(void)
+{
+  // cut power after each operation of a save (record A saved before, record B being saved)
+  for (int operations = 0; operations < 8; operations++)
+  {
+    setUp();
+    ConfigStore configStore = store();
+    TEST_ASSERT_TRUE(configStore.save(jsonA, strlen(jsonA), (const uint8_t *)&recordA));
+
+    fs.operationsLeft = operations;
+    bool saved = configStore.save(jsonB, strlen(jsonB), (const uint8_t *)&recordB);
+    fs.operationsLeft = -1;
+
+    // reboot : previous config or new one, JSON and record always match
+    Record loaded;
+    TEST_ASSERT_EQUAL(ConfigStore::LoadRecord, configStore.load((uint8_t *)&loaded));
+    bool isA = !memcmp(&loaded, &recordA, sizeof(Record));
+    bool isB = !memcmp(&loaded, &recordB, sizeof(Record));
+    TEST_ASSERT_TRUE(isA || isB);
+    if (saved)
+      TEST_ASSERT_TRUE(isB);
+
+    const std::vector<uint8_t> &json = fs.files["/WPalaControl.json"];
+    const char *expectedJson = isB ? jsonB : jsonA;
+    TEST_ASSERT_EQUAL(strlen(expectedJson), json.size());
+    TEST_ASSERT_EQUAL_MEMORY(expectedJson, json.data(), json.size());
+
+    // temporary files are cleaned up
+    TEST_ASSERT_EQUAL(2, (int)fs.files.size());
+  }
+}
+
+void test_load_time(void)
+{
+  ConfigStore configStore = store();
+  TEST_ASSERT_TRUE(configStore.save(jsonA, strlen(jsonA), (const uint8_t *)&recordA));
+
+  const uint32_t runs = 10000;
+  Record loaded;
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < runs; i++)
+    TEST_ASSERT_EQUAL(ConfigStore::LoadRecord, configStore.load((uint8_t *)&loaded));
+  double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / runs;
+
+  char message[96];
+  snprintf(message, sizeof(message), "record load (JSON CRC check included) : %.2f us on host", micros);
+  TEST_MESSAGE(message);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip);
+  RUN_TEST(test_no_config);
+  RUN_TEST(test_legacy_json_migration);
+  RUN_TEST(test_json_changed_after_rollback);
+  RUN_TEST(test_corrupted_record);
+  RUN_TEST(test_power_cut_during_save);
+  RUN_TEST(test_load_time);
+  return UNITY_END();
+}
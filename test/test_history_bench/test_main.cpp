@@ -0,0 +1,172 @@
+// History codec benchmarks : compression ratio, encode cost and decode throughput (pio test -e native)
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include "HistoryCodec.h"
+
+#define BLOCK_SIZE 256   // same as HISTORY_FS_BLOCK_SIZE
+#define BLOCK_SAMPLES 12 // same as HISTORY_FS_BLOCK_SAMPLES
+#define DAYS 60          // whole flash tier (HISTORY_FS_BLOCKS blocks)
+#define SAMPLES (DAYS * 24)
+
+// a sample in RAM tiers : time + fields
+#define RAW_SAMPLE_BYTES (4 + HISTORY_FIELD_COUNT * 2)
+
+// encoding runs in loop() twice a day, it must not stall it more than this on ESP8266 (80MHz)
+#define ESP8266_BLOCK_BUDGET_US 2000
+// host is at least this much faster than ESP8266 for this integer code
+#define HOST_SPEEDUP 20
+
+static const int16_t NoValue = INT16_MIN;
+static HistorySample samples[SAMPLES];
+
+static double nowMicros()
+{
+  return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// hour averages of a stove heating in the evening and the morning (fields in HistorySample order :
+// T1-T5 and SETP x10, PWR, STATUS, F2L, DP, PQT)
+static void simulateStove()
+{
+  uint32_t seed = 42;
+  uint32_t pellets = 0;
+
+  for (uint32_t i = 0; i < SAMPLES; i++)
+  {
+    uint8_t hour = i % 24;
+    bool heating = (hour >= 6 && hour < 9) || (hour >= 17 && hour < 23);
+    seed = seed * 1103515245 + 12345;
+    int16_t noise = (int16_t)((seed >> 16) % 7) - 3;
+
+    HistorySample &sample = samples[i];
+    sample.time = 1700000000 + i * 3600 + (seed >> 28); // stove clock jitter
+    int16_t room = (int16_t)(180 + 20 * sin(i * 2 * M_PI / 24) + (heating ? 25 : 0));
+    sample.values[0] = heating ? 1500 + noise * 10 : 250 + noise; // T1 : smoke
+    sample.values[1] = room + noise;                              // T2 : room
+    sample.values[2] = heating ? 600 + noise * 3 : 200 + noise;   // T3 : water
+    sample.values[3] = NoValue;                                   // T4 : no probe
+    sample.values[4] = 50 + (int16_t)(30 * sin(i * 2 * M_PI / 24)); // T5 : outdoor
+    sample.values[5] = 210;                                       // SETP
+    sample.values[6] = heating ? 3 + (hour % 2) : 1;              // PWR
+    sample.values[7] = heating ? 6 : 0;                           // STATUS
+    sample.values[8] = heating ? 2 : 0;                           // F2L
+    sample.values[9] = heating ? 45 + noise : 0;                  // DP
+    pellets += heating ? 1 : 0;
+    sample.values[10] = (int16_t)pellets;                         // PQT
+  }
+}
+
+// encode samples like StoveHistory::writeBlockFS (as many samples as fit in a block), return total size
+static uint32_t encodeAll(uint16_t &blocks)
+{
+  uint8_t block[BLOCK_SIZE];
+  uint32_t bytes = 0;
+  blocks = 0;
+
+  for (uint32_t first = 0; first < SAMPLES;)
+  {
+    uint16_t nb = (SAMPLES - first < BLOCK_SAMPLES) ? SAMPLES - first : BLOCK_SAMPLES;
+    uint16_t size;
+    while (!(size = historyEncodeBlock(samples + first, nb, block, sizeof(block))) && nb > 1)
+      nb--;
+    TEST_ASSERT_TRUE(size != 0);
+
+    blocks++;
+    bytes += size;
+    first += nb;
+  }
+
+  return bytes;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_bytes_per_sample(void)
+{
+  uint16_t blocks;
+  uint32_t bytes = encodeAll(blocks);
+  double bytesPerSample = (double)bytes / SAMPLES;
+
+  char message[128];
+  snprintf(message, sizeof(message), "%u samples in %u blocks : %u bytes, %.2f bytes/sample (raw %u)", SAMPLES, blocks, bytes, bytesPerSample, RAW_SAMPLE_BYTES);
+  TEST_MESSAGE(message);
+
+  // compressed sample (header included) must use less than half of a raw one
+  TEST_ASSERT_LESS_THAN_UINT32(RAW_SAMPLE_BYTES * SAMPLES / 2, bytes);
+  // blocks are filled (a block holds 12 hours)
+  TEST_ASSERT_EQUAL_UINT32(SAMPLES / BLOCK_SAMPLES, blocks);
+}
+
+void test_encode_cost(void)
+{
+  const uint32_t runs = 200;
+  uint16_t blocks;
+
+  double start = nowMicros();
+  for (uint32_t run = 0; run < runs; run++)
+    encodeAll(blocks);
+  double perSample = (nowMicros() - start) / (runs * SAMPLES);
+  double perBlock = perSample * BLOCK_SAMPLES;
+
+  char message[128];
+  snprintf(message, sizeof(message), "encode : %.3f us/sample, %.2f us/block on host (ESP8266 budget %u us/block)", perSample, perBlock, ESP8266_BLOCK_BUDGET_US);
+  TEST_MESSAGE(message);
+
+  TEST_ASSERT_LESS_THAN_UINT32(ESP8266_BLOCK_BUDGET_US / HOST_SPEEDUP, (uint32_t)perBlock);
+}
+
+void test_decode_throughput(void)
+{
+  // encoded flash tier (like stored files)
+  static uint8_t blocks[SAMPLES / BLOCK_SAMPLES][BLOCK_SIZE];
+  static uint16_t sizes[SAMPLES / BLOCK_SAMPLES];
+  uint16_t nbBlocks = 0;
+  for (uint32_t first = 0; first < SAMPLES; first += BLOCK_SAMPLES, nbBlocks++)
+  {
+    sizes[nbBlocks] = historyEncodeBlock(samples + first, BLOCK_SAMPLES, blocks[nbBlocks], BLOCK_SIZE);
+    TEST_ASSERT_TRUE(sizes[nbBlocks] != 0);
+  }
+
+  const uint32_t runs = 200;
+  HistorySample decoded[BLOCK_SAMPLES];
+  uint32_t decodedSamples = 0;
+  uint32_t checksum = 0;
+
+  double start = nowMicros();
+  for (uint32_t run = 0; run < runs; run++)
+    for (uint16_t i = 0; i < nbBlocks; i++)
+    {
+      uint16_t nb = historyDecodeBlock(blocks[i], sizes[i], decoded, BLOCK_SAMPLES);
+      decodedSamples += nb;
+      checksum += decoded[nb - 1].time;
+    }
+  double elapsed = nowMicros() - start;
+
+  uint32_t compressedBytes = 0;
+  for (uint16_t i = 0; i < nbBlocks; i++)
+    compressedBytes += sizes[i];
+
+  double samplesPerSecond = decodedSamples / elapsed * 1e6;
+  char message[128];
+  snprintf(message, sizeof(message), "decode : %.0f samples/s, %.1f MB/s of compressed data on host (checksum %u)", samplesPerSecond, (double)compressedBytes * runs / elapsed, checksum);
+  TEST_MESSAGE(message);
+
+  TEST_ASSERT_EQUAL_UINT32(runs * SAMPLES, decodedSamples);
+  // a whole 60 days export (1440 samples) must decode in less than 10ms on host
+  TEST_ASSERT_GREATER_THAN_UINT32(SAMPLES * 100, (uint32_t)samplesPerSecond);
+}
+
+int main(int argc, char **argv)
+{
+  simulateStove();
+
+  UNITY_BEGIN();
+  RUN_TEST(test_bytes_per_sample);
+  RUN_TEST(test_encode_cost);
+  RUN_TEST(test_decode_throughput);
+  return UNITY_END();
+}
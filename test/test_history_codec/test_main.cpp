@@ -0,0 +1,143 @@
+// History block codec round trip (pio test -e native)
+#include <unity.h>
+#include <string.h>
+#include "HistoryCodec.h"
+
+#define BLOCK_SIZE 256
+#define BLOCK_SAMPLES 12
+
+static const int16_t NoValue = INT16_MIN;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static void fillSamples(HistorySample *samples, uint16_t nb)
+{
+  for (uint16_t i = 0; i < nb; i++)
+  {
+    // hourly samples with some clock jitter
+    samples[i].time = 1700000000 + i * 3600 + (i % 3 ? 0 : 2) - (i % 5 ? 0 : 1);
+    for (uint8_t field = 0; field < HISTORY_FIELD_COUNT; field++)
+      samples[i].values[field] = (int16_t)(200 + field * 17 + (i * (field + 1)) % 23 - 11);
+  }
+
+  // missing values, negative values and a state change
+  samples[nb / 2].values[9] = NoValue;
+  samples[nb / 3].values[4] = -125;
+  samples[nb - 1].values[7] = 6;
+}
+
+static void assertRoundTrip(const HistorySample *samples, uint16_t nb)
+{
+  uint8_t block[BLOCK_SIZE];
+  HistorySample decoded[BLOCK_SAMPLES];
+
+  uint16_t size = historyEncodeBlock(samples, nb, block, sizeof(block));
+  TEST_ASSERT_TRUE(size > sizeof(HistoryBlockHeader));
+  TEST_ASSERT_TRUE(size <= sizeof(block));
+
+  TEST_ASSERT_EQUAL_UINT16(nb, historyDecodeBlock(block, size, decoded, BLOCK_SAMPLES));
+  for (uint16_t i = 0; i < nb; i++)
+  {
+    TEST_ASSERT_EQUAL_UINT32(samples[i].time, decoded[i].time);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(samples[i].values, decoded[i].values, HISTORY_FIELD_COUNT);
+  }
+}
+
+void test_round_trip_full_block(void)
+{
+  HistorySample samples[BLOCK_SAMPLES];
+  fillSamples(samples, BLOCK_SAMPLES);
+  assertRoundTrip(samples, BLOCK_SAMPLES);
+}
+
+void test_round_trip_single_sample(void)
+{
+  HistorySample samples[1];
+  fillSamples(samples, 1);
+  assertRoundTrip(samples, 1);
+}
+
+void test_round_trip_time_gaps(void)
+{
+  // stove clock changes and reboots give big deltas (all time buckets are used)
+  HistorySample samples[BLOCK_SAMPLES];
+  fillSamples(samples, BLOCK_SAMPLES);
+  const int32_t gaps[BLOCK_SAMPLES] = {0, 3600, 3660, 3400, 5000, 86400, 3600, 1, 7200, 100000, 3600, 3599};
+  for (uint16_t i = 1; i < BLOCK_SAMPLES; i++)
+    samples[i].time = samples[i - 1].time + gaps[i];
+  assertRoundTrip(samples, BLOCK_SAMPLES);
+}
+
+void test_random_values_overflow(void)
+{
+  // uncompressible values don't fit : encoder must report it without writing past the block
+  HistorySample samples[BLOCK_SAMPLES];
+  uint32_t seed = 12345;
+  for (uint16_t i = 0; i < BLOCK_SAMPLES; i++)
+  {
+    samples[i].time = 1700000000 + i * 3600;
+    for (uint8_t field = 0; field < HISTORY_FIELD_COUNT; field++)
+    {
+      seed = seed * 1103515245 + 12345;
+      samples[i].values[field] = (int16_t)(seed >> 16);
+    }
+  }
+
+  uint8_t block[BLOCK_SIZE + 4];
+  memset(block + BLOCK_SIZE, 0xA5, 4);
+  TEST_ASSERT_EQUAL_UINT16(0, historyEncodeBlock(samples, BLOCK_SAMPLES, block, BLOCK_SIZE));
+  for (uint8_t i = 0; i < 4; i++)
+    TEST_ASSERT_EQUAL_HEX8(0xA5, block[BLOCK_SIZE + i]);
+
+  // fewer samples fit
+  assertRoundTrip(samples, 4);
+}
+
+void test_corrupted_header_rejected(void)
+{
+  HistorySample samples[BLOCK_SAMPLES];
+  HistorySample decoded[BLOCK_SAMPLES];
+  uint8_t block[BLOCK_SIZE];
+  fillSamples(samples, BLOCK_SAMPLES);
+  uint16_t size = historyEncodeBlock(samples, BLOCK_SAMPLES, block, sizeof(block));
+
+  HistoryBlockHeader header;
+  memcpy(&header, block, sizeof(header));
+
+  // size smaller than header
+  HistoryBlockHeader corrupted = header;
+  corrupted.size = sizeof(HistoryBlockHeader) - 1;
+  memcpy(block, &corrupted, sizeof(corrupted));
+  TEST_ASSERT_EQUAL_UINT16(0, historyDecodeBlock(block, size, decoded, BLOCK_SAMPLES));
+
+  // size bigger than data read
+  corrupted = header;
+  memcpy(block, &corrupted, sizeof(corrupted));
+  TEST_ASSERT_EQUAL_UINT16(0, historyDecodeBlock(block, size - 1, decoded, BLOCK_SAMPLES));
+
+  // too many samples
+  corrupted.samples = BLOCK_SAMPLES + 1;
+  memcpy(block, &corrupted, sizeof(corrupted));
+  TEST_ASSERT_EQUAL_UINT16(0, historyDecodeBlock(block, size, decoded, BLOCK_SAMPLES));
+
+  // other version
+  corrupted = header;
+  corrupted.version = HISTORY_BLOCK_VERSION + 1;
+  memcpy(block, &corrupted, sizeof(corrupted));
+  TEST_ASSERT_EQUAL_UINT16(0, historyDecodeBlock(block, size, decoded, BLOCK_SAMPLES));
+
+  // truncated file
+  TEST_ASSERT_EQUAL_UINT16(0, historyDecodeBlock(block, sizeof(HistoryBlockHeader) - 1, decoded, BLOCK_SAMPLES));
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip_full_block);
+  RUN_TEST(test_round_trip_single_sample);
+  RUN_TEST(test_round_trip_time_gaps);
+  RUN_TEST(test_random_values_overflow);
+  RUN_TEST(test_corrupted_header_rejected);
+  return UNITY_END();
+}
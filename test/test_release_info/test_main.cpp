@@ -0,0 +1,270 @@
+// Latest release info parsing and caching, against a local HTTP server standing in for GitHub API (pio test -e native)
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "ReleaseInfo.h"
+
+#define CACHE_TTL 900000 // same as UPDATE_INFO_CACHE_TTL
+
+// shortened GitHub releases/latest answer (assets also have "name" keys)
+static const char releaseJson[] =
+    "{\"url\":\"https://api.github.com/repos/Domochip/WPalaControl/releases/1\","
+    "\"assets\":[{\"name\":\"WPalaControl.esp8266.4.2.1.bin\",\"label\":\"\",\"size\":512000},"
+    "{\"name\":\"WPalaControl.esp32.4.2.1.bin\",\"tag_name\":\"nested\",\"body\":\"{not [top\"}],"
+    "\"html_url\":\"https://github.com/Domochip/WPalaControl/releases/tag/4.2.1\","
+    "\"tag_name\":\"4.2.1\",\"name\":\"WPalaControl 4.2.1 \\\"fixes\\\"\","
+    "\"published_at\":\"2026-09-30T18:02:11Z\","
+    "\"body\":\"Stove bus queue\\r\\nFaster WebSocket answers\\r\\n\\r\\n## Full changelog\\r\\nv4.2.0...v4.2.1\","
+    "\"mentions_count\":2}";
+
+// local HTTP server : answers 304 when If-None-Match matches current ETag
+static int listenSocket = -1;
+static uint16_t serverPort = 0;
+static std::thread server;
+static std::atomic<int> requestCount;
+static std::atomic<int> notModifiedCount;
+static std::string currentEtag;
+static std::string currentJson;
+
+static void serverTask()
+{
+  int client;
+  while ((client = accept(listenSocket, nullptr, nullptr)) >= 0)
+  {
+    std::string request;
+    char buf[512];
+    ssize_t len;
+    while (request.find("\r\n\r\n") == std::string::npos && (len = recv(client, buf, sizeof(buf), 0)) > 0)
+      request.append(buf, len);
+
+    requestCount++;
+
+    std::string answer;
+    if (request.find("If-None-Match: " + currentEtag + "\r\n") != std::string::npos)
+    {
+      notModifiedCount++;
+      answer = "HTTP/1.1 304 Not Modified\r\nETag: " + currentEtag + "\r\nConnection: close\r\n\r\n";
+    }
+    else
+      answer = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nETag: " + currentEtag +
+               "\r\nContent-Length: " + std::to_string(currentJson.size()) + "\r\nConnection: close\r\n\r\n" + currentJson;
+
+    send(client, answer.data(), answer.size(), 0);
+    close(client);
+  }
+}
+
+// same steps as Application::getLastestUpdateInfo, using a plain socket instead of HTTPClient
+static bool getLatestUpdateInfo(ReleaseInfoCache &cache, unsigned long nowMillis, bool revalidate = false)
+{
+  if (cache.fresh(nowMillis, CACHE_TTL, revalidate))
+    return cache.valid();
+
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(serverPort);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(sock, (sockaddr *)&addr, sizeof(addr)) != 0)
+  {
+    close(sock);
+    return cache.valid();
+  }
+
+  std::string request = "GET /repos/Domochip/WPalaControl/releases/latest HTTP/1.1\r\nHost: localhost\r\n";
+  if (cache.ifNoneMatch())
+    request += std::string("If-None-Match: ") + cache.ifNoneMatch() + "\r\n";
+  request += "\r\n";
+  send(sock, request.data(), request.size(), 0);
+
+  // read status line and headers
+  std::string headers;
+  char c;
+  while (headers.find("\r\n\r\n") == std::string::npos && recv(sock, &c, 1, 0) == 1)
+    headers += c;
+
+  int httpCode = 0;
+  sscanf(headers.c_str(), "HTTP/1.1 %d", &httpCode);
+
+  std::string etag;
+  size_t etagPos = headers.find("ETag: ");
+  if (etagPos != std::string::npos)
+    etag = headers.substr(etagPos + 6, headers.find("\r\n", etagPos) - etagPos - 6);
+
+  if (httpCode == 304)
+    cache.notModified(nowMillis);
+  else if (httpCode == 200)
+  {
+    // body is parsed one char at a time, as it comes from the stream
+    ReleaseInfo info;
+    ReleaseInfoParser parser(info);
+    while (recv(sock, &c, 1, 0) == 1 && parser.feed(c))
+      ;
+    cache.update(info, etag.c_str(), nowMillis);
+  }
+
+  close(sock);
+  return cache.valid();
+}
+
+static void parse(const char *json, ReleaseInfo &info)
+{
+  ReleaseInfoParser parser(info);
+  while (*json && parser.feed(*json))
+    json++;
+}
+
+void setUp(void)
+{
+  requestCount = 0;
+  notModifiedCount = 0;
+  currentEtag = "W/\"8f2c1d\"";
+  currentJson = releaseJson;
+}
+
+void tearDown(void)
+{
+}
+
+void test_parse_release(void)
+{
+  ReleaseInfo info;
+  ReleaseInfoParser parser(info);
+  const char *json = releaseJson;
+  while (*json && parser.feed(*json))
+    json++;
+
+  TEST_ASSERT_TRUE(parser.complete());
+  // answer tail is not needed once all keys are read
+  TEST_ASSERT_TRUE(*json != 0);
+
+  // keys nested in assets are ignored, first word of name is skipped, escapes are decoded
+  TEST_ASSERT_EQUAL_STRING("4.2.1", info.version);
+  TEST_ASSERT_EQUAL_STRING("4.2.1 \"fixes\"", info.title);
+  TEST_ASSERT_EQUAL_STRING("2026-09-30", info.releaseDate);
+  // summary stops at the first "##" title
+  TEST_ASSERT_EQUAL_STRING("Stove bus queue\r\nFaster WebSocket answers", info.summary);
+}
+
+void test_parse_truncated_values(void)
+{
+  std::string longBody(600, 'x');
+  std::string json = "{\"tag_name\":\"v10.20.30-beta.4\",\"name\":\"Single\",\"published_at\":\"2026-01-02\",\"body\":\"" + longBody + "\"}";
+
+  ReleaseInfo info;
+  parse(json.c_str(), info);
+
+  TEST_ASSERT_EQUAL_STRING("v10.20.30", info.version);
+  // single word name gives an empty title
+  TEST_ASSERT_EQUAL_STRING("", info.title);
+  TEST_ASSERT_EQUAL_STRING("2026-01-02", info.releaseDate);
+  TEST_ASSERT_EQUAL(sizeof(info.summary) - 1, strlen(info.summary));
+}
+
+void test_parse_incomplete_answer(void)
+{
+  ReleaseInfo info;
+  ReleaseInfoParser parser(info);
+  const char json[] = "{\"message\":\"API rate limit exceeded\",\"documentation_url\":\"https://docs.github.com\"}";
+  for (const char *p = json; *p; p++)
+    parser.feed(*p);
+
+  TEST_ASSERT_FALSE(parser.complete());
+
+  // an answer without version never replaces cached info
+  ReleaseInfoCache cache;
+  TEST_ASSERT_FALSE(cache.update(info, "W/\"1\"", 0));
+  TEST_ASSERT_FALSE(cache.valid());
+  TEST_ASSERT_NULL(cache.ifNoneMatch());
+}
+
+void test_cache_fresh_without_request(void)
+{
+  ReleaseInfoCache cache;
+
+  TEST_ASSERT_TRUE(getLatestUpdateInfo(cache, 1000));
+  TEST_ASSERT_EQUAL(1, requestCount.load());
+  TEST_ASSERT_EQUAL_STRING("4.2.1", cache.info().version);
+  TEST_ASSERT_EQUAL_STRING(currentEtag.c_str(), cache.ifNoneMatch());
+
+  // page loads and MQTT publishes within TTL don't reach the server
+  for (unsigned long t = 1000; t < 1000 + CACHE_TTL; t += CACHE_TTL / 10)
+    TEST_ASSERT_TRUE(getLatestUpdateInfo(cache, t));
+  TEST_ASSERT_EQUAL(1, requestCount.load());
+}
+
+void test_cache_revalidate(void)
+{
+  ReleaseInfoCache cache;
+  TEST_ASSERT_TRUE(getLatestUpdateInfo(cache, 1000));
+
+  // Refresh button : conditional request answered 304, cached info kept
+  TEST_ASSERT_TRUE(getLatestUpdateInfo(cache, 2000, true));
+  TEST_ASSERT_EQUAL(2, requestCount.load());
+  TEST_ASSERT_EQUAL(1, notModifiedCount.load());
+  TEST_ASSERT_EQUAL_STRING("4.2.1", cache.info().version);
+
+  // TTL expired : revalidated too, and 304 restarts the TTL
+  TEST_ASSERT_TRUE(getLatestUpdateInfo(cache, 2000 + CACHE_TTL));
+  TEST_ASSERT_EQUAL(3, requestCount.load());
+  TEST_ASSERT_EQUAL(2, notModifiedCount.load());
+  TEST_ASSERT_TRUE(getLatestUpdateInfo(cache, 2000 + CACHE_TTL + 1));
+  TEST_ASSERT_EQUAL(3, requestCount.load());
+}
+
+void test_cache_new_release(void)
+{
+  ReleaseInfoCache cache;
+  TEST_ASSERT_TRUE(getLatestUpdateInfo(cache, 1000));
+
+  // new release published : fresh cache still serves the old one until TTL or Refresh
+  currentEtag = "W/\"a47e90\"";
+  currentJson = "{\"tag_name\":\"4.3.0\",\"name\":\"WPalaControl 4.3.0\",\"published_at\":\"2026-10-15T07:00:00Z\",\"body\":\"Flash history\"}";
+  TEST_ASSERT_TRUE(getLatestUpdateInfo(cache, 5000));
+  TEST_ASSERT_EQUAL_STRING("4.2.1", cache.info().version);
+
+  TEST_ASSERT_TRUE(getLatestUpdateInfo(cache, 6000, true));
+  TEST_ASSERT_EQUAL(2, requestCount.load());
+  TEST_ASSERT_EQUAL(0, notModifiedCount.load());
+  TEST_ASSERT_EQUAL_STRING("4.3.0", cache.info().version);
+  TEST_ASSERT_EQUAL_STRING("4.3.0", cache.info().title);
+  TEST_ASSERT_EQUAL_STRING("2026-10-15", cache.info().releaseDate);
+  TEST_ASSERT_EQUAL_STRING("Flash history", cache.info().summary);
+  TEST_ASSERT_EQUAL_STRING(currentEtag.c_str(), cache.ifNoneMatch());
+}
+
+int main(int argc, char **argv)
+{
+  listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addrLen = sizeof(addr);
+  if (bind(listenSocket, (sockaddr *)&addr, addrLen) != 0 || listen(listenSocket, 4) != 0 || getsockname(listenSocket, (sockaddr *)&addr, &addrLen) != 0)
+    return 1;
+  serverPort = ntohs(addr.sin_port);
+  server = std::thread(serverTask);
+
+  UNITY_BEGIN();
+  RUN_TEST(test_parse_release);
+  RUN_TEST(test_parse_truncated_values);
+  RUN_TEST(test_parse_incomplete_answer);
+  RUN_TEST(test_cache_fresh_without_request);
+  RUN_TEST(test_cache_revalidate);
+  RUN_TEST(test_cache_new_release);
+  int result = UNITY_END();
+
+  // unblock accept() so the server thread ends
+  shutdown(listenSocket, SHUT_RDWR);
+  close(listenSocket);
+  server.join();
+
+  return result;
+}
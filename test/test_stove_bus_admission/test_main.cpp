@@ -0,0 +1,113 @@
+// Stove bus admission of user commands and publish cycles (pio test -e native)
+#include <unity.h>
+#include "StoveBusAdmission.h"
+
+#define CAPACITY 15         // same as STOVE_BUS_QUEUE_SIZE - 1
+#define BACKGROUND_SLOTS 10 // same as STOVE_BUS_BACKGROUND_SLOTS
+#define CYCLE_COMMANDS 8    // commands queued by publishTick
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// queue a publish cycle like publishTick : all commands or none
+static bool submitCycle(StoveBusAdmission &admission)
+{
+  if (admission.available(true) < CYCLE_COMMANDS)
+  {
+    admission.refuse(CYCLE_COMMANDS);
+    return false;
+  }
+
+  for (uint8_t i = 0; i < CYCLE_COMMANDS; i++)
+    TEST_ASSERT_TRUE(admission.admit(true));
+
+  return true;
+}
+
+void test_cycle_with_user_job_in_flight(void)
+{
+  StoveBusAdmission admission(CAPACITY, BACKGROUND_SLOTS);
+
+  // a slow user command (memory dump, restore...) is running when the publish tick fires
+  TEST_ASSERT_TRUE(admission.admit(false));
+
+  // whole cycle is queued, none of its tail is dropped
+  TEST_ASSERT_TRUE(submitCycle(admission));
+  TEST_ASSERT_EQUAL_UINT8(CYCLE_COMMANDS, admission.backgroundInFlight());
+  TEST_ASSERT_EQUAL_UINT8(CYCLE_COMMANDS + 1, admission.inFlight());
+  TEST_ASSERT_EQUAL_UINT32(0, admission.refused());
+}
+
+void test_cycle_with_user_jobs_filling_their_share(void)
+{
+  StoveBusAdmission admission(CAPACITY, BACKGROUND_SLOTS);
+
+  // user commands can use every slot not reserved to background polling
+  for (uint8_t i = 0; i < CAPACITY - BACKGROUND_SLOTS; i++)
+    TEST_ASSERT_TRUE(admission.admit(false));
+
+  TEST_ASSERT_TRUE(submitCycle(admission));
+  TEST_ASSERT_EQUAL_UINT32(0, admission.refused());
+}
+
+void test_cycle_refused_as_a_whole(void)
+{
+  StoveBusAdmission admission(CAPACITY, BACKGROUND_SLOTS);
+
+  // user commands took more than their share while background was idle
+  for (uint8_t i = 0; i < CAPACITY - CYCLE_COMMANDS + 1; i++)
+    TEST_ASSERT_TRUE(admission.admit(false));
+
+  // cycle doesn't fit : nothing is queued (no partial cycle) and refusal is counted
+  TEST_ASSERT_FALSE(submitCycle(admission));
+  TEST_ASSERT_EQUAL_UINT8(0, admission.backgroundInFlight());
+  TEST_ASSERT_EQUAL_UINT32(CYCLE_COMMANDS, admission.refused());
+
+  // once one user command is answered, next tick queues the whole cycle
+  admission.release(false);
+  TEST_ASSERT_TRUE(submitCycle(admission));
+}
+
+void test_user_room_kept_from_background(void)
+{
+  StoveBusAdmission admission(CAPACITY, BACKGROUND_SLOTS);
+
+  // background polling can't take more than its share
+  for (uint8_t i = 0; i < BACKGROUND_SLOTS; i++)
+    TEST_ASSERT_TRUE(admission.admit(true));
+  TEST_ASSERT_FALSE(admission.admit(true));
+  TEST_ASSERT_EQUAL_UINT32(1, admission.refused());
+
+  // user commands still find room until capacity is reached
+  for (uint8_t i = 0; i < CAPACITY - BACKGROUND_SLOTS; i++)
+    TEST_ASSERT_TRUE(admission.admit(false));
+  TEST_ASSERT_FALSE(admission.admit(false));
+  TEST_ASSERT_EQUAL_UINT8(CAPACITY, admission.inFlight());
+  TEST_ASSERT_EQUAL_UINT8(0, admission.available(false));
+}
+
+void test_release(void)
+{
+  StoveBusAdmission admission(CAPACITY, BACKGROUND_SLOTS);
+
+  TEST_ASSERT_TRUE(admission.admit(true));
+  TEST_ASSERT_TRUE(admission.admit(false));
+  admission.release(true);
+  admission.release(false);
+
+  TEST_ASSERT_EQUAL_UINT8(0, admission.inFlight());
+  TEST_ASSERT_EQUAL_UINT8(0, admission.backgroundInFlight());
+  TEST_ASSERT_EQUAL_UINT8(BACKGROUND_SLOTS, admission.available(true));
+  TEST_ASSERT_EQUAL_UINT8(CAPACITY, admission.available(false));
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_cycle_with_user_job_in_flight);
+  RUN_TEST(test_cycle_with_user_jobs_filling_their_share);
+  RUN_TEST(test_cycle_refused_as_a_whole);
+  RUN_TEST(test_user_room_kept_from_background);
+  RUN_TEST(test_release);
+  return UNITY_END();
+}
@@ -0,0 +1,138 @@
+// WebSocket command round trip through the stove bus queues, with a thread acting as the stove bus task (pio test -e native)
+#include <unity.h>
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "SpscQueue.h"
+#include "WsSessions.h"
+
+#define QUEUE_SIZE 16    // same as STOVE_BUS_QUEUE_SIZE
+#define CLIENTS 5        // same as WEBSOCKETS_SERVER_CLIENT_MAX
+#define REQUESTS 2000
+#define STOVE_MICROS 200 // simulated stove answer time
+
+typedef struct
+{
+  WsSession session;
+  uint32_t id;
+  std::chrono::steady_clock::time_point submitTime;
+} Job;
+
+static SpscQueue<Job *, QUEUE_SIZE> requests;
+static SpscQueue<Job *, QUEUE_SIZE> results;
+static std::atomic<bool> running;
+static std::thread stoveBus;
+static WsSessions<CLIENTS> sessions;
+
+// stove bus task : execute queued commands one by one
+static void stoveBusTask()
+{
+  Job *job;
+  while (running)
+  {
+    if (!requests.pop(job))
+    {
+      std::this_thread::yield();
+      continue;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(STOVE_MICROS));
+    while (!results.push(job))
+      std::this_thread::yield();
+  }
+}
+
+// loop() side : wait for next result
+static Job *waitResult()
+{
+  Job *job;
+  while (!results.pop(job))
+    std::this_thread::yield();
+  return job;
+}
+
+void setUp(void)
+{
+  running = true;
+  stoveBus = std::thread(stoveBusTask);
+}
+
+void tearDown(void)
+{
+  running = false;
+  stoveBus.join();
+}
+
+void test_round_trip_latency(void)
+{
+  static uint32_t rtt[REQUESTS];
+  sessions.changed(0); // client connected
+
+  for (uint32_t i = 0; i < REQUESTS; i++)
+  {
+    Job *job = new Job{sessions.session(0), i, std::chrono::steady_clock::now()};
+    TEST_ASSERT_TRUE(requests.push(job));
+
+    job = waitResult();
+    TEST_ASSERT_EQUAL_UINT32(i, job->id);
+    TEST_ASSERT_TRUE(sessions.isCurrent(job->session));
+    rtt[i] = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - job->submitTime).count();
+    delete job;
+  }
+
+  std::sort(rtt, rtt + REQUESTS);
+  uint32_t p50 = rtt[REQUESTS / 2], p99 = rtt[REQUESTS * 99 / 100], max = rtt[REQUESTS - 1];
+
+  char message[128];
+  snprintf(message, sizeof(message), "round trip (stove %uus) : p50 %uus, p99 %uus, max %uus", STOVE_MICROS, p50, p99, max);
+  TEST_MESSAGE(message);
+
+  // queues add little to the stove answer time
+  TEST_ASSERT_GREATER_OR_EQUAL_UINT32(STOVE_MICROS, rtt[0]);
+  TEST_ASSERT_LESS_THAN_UINT32(STOVE_MICROS + 2000, p50);
+}
+
+void test_answers_follow_their_connection(void)
+{
+  // three requests from client 1, client disconnects while they are queued and another one takes its slot
+  sessions.changed(1);
+  WsSession first = sessions.session(1);
+  for (uint32_t i = 0; i < 3; i++)
+    TEST_ASSERT_TRUE(requests.push(new Job{first, i, std::chrono::steady_clock::now()}));
+
+  sessions.changed(1); // disconnected
+  sessions.changed(1); // new client connected in the same slot
+  WsSession second = sessions.session(1);
+  TEST_ASSERT_TRUE(requests.push(new Job{second, 3, std::chrono::steady_clock::now()}));
+
+  // only the answer to the new connection is sent
+  uint32_t sent = 0, dropped = 0;
+  for (uint32_t i = 0; i < 4; i++)
+  {
+    Job *job = waitResult();
+    if (sessions.isCurrent(job->session))
+    {
+      TEST_ASSERT_EQUAL_UINT32(3, job->id);
+      sent++;
+    }
+    else
+      dropped++;
+    delete job;
+  }
+  TEST_ASSERT_EQUAL_UINT32(1, sent);
+  TEST_ASSERT_EQUAL_UINT32(3, dropped);
+
+  // other slots are not affected
+  TEST_ASSERT_TRUE(sessions.isCurrent(sessions.session(0)));
+  // unknown slot is never current
+  TEST_ASSERT_FALSE(sessions.isCurrent(WsSession{CLIENTS, 0}));
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_round_trip_latency);
+  RUN_TEST(test_answers_follow_their_connection);
+  return UNITY_END();
+}